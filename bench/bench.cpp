@@ -0,0 +1,278 @@
+// Times the stages of an extraction over a set of XNB files: reading the
+// header and decompressing the contents, reading the objects through the
+// readers, and exporting them. Files are read into memory up front so the
+// disk only shows up in the export stage.
+//
+//   make bench && bin/bench [-r <runs>] [--json <file>] <file.xnb | dir>...
+
+#include "emitter.hpp"
+#include "export.hpp"
+#include "libxnb.hpp"
+#include "util.hpp"
+#include "xnb.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct Input
+{
+    fs::path path;
+    std::vector<uint8_t> bytes;
+};
+
+enum Stage
+{
+    Decompress,
+    Read,
+    Export,
+    STAGE_COUNT
+};
+
+const char *STAGE_NAMES[STAGE_COUNT] = {"decompress", "read", "export"};
+
+struct Stats
+{
+    double min;
+    double median;
+    double p99;
+};
+
+void load(const fs::path &path, std::vector<Input> &inputs)
+{
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(stream)),
+                               std::istreambuf_iterator<char>());
+    inputs.push_back({path, std::move(bytes)});
+}
+
+// Identifies the set of files, so results are only compared between runs
+// over the same corpus. FNV-1a over the sizes and contents in path order.
+uint64_t fingerprint(const std::vector<Input> &inputs)
+{
+    uint64_t hash = 0xCBF29CE484222325;
+    auto add = [&](uint8_t byte) { hash = (hash ^ byte) * 0x100000001B3; };
+
+    for (auto &input : inputs) {
+        for (int i = 0; i < 8; ++i) {
+            add(uint8_t(input.bytes.size() >> (8 * i)));
+        }
+        for (uint8_t byte : input.bytes) {
+            add(byte);
+        }
+    }
+    return hash;
+}
+
+// Nearest rank percentiles over the times of every run, in seconds.
+Stats summarize(std::vector<double> times)
+{
+    std::sort(times.begin(), times.end());
+    auto rank = [&](double p) {
+        size_t i = size_t(p * times.size() + 0.999999);
+        return times[std::clamp<size_t>(i, 1, times.size()) - 1];
+    };
+    return {times.front(), rank(0.5), rank(0.99)};
+}
+
+void usage(const char *name)
+{
+    std::cerr << "usage: " << name
+              << " [-r <runs>] [--json <file>] <file.xnb | dir>...\n"
+              << "  -r <n>         time n runs over the files (default: 10)\n"
+              << "  --json <file>  also write the results as JSON, - for"
+              << " stdout\n";
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int runs = 10;
+    std::string json;
+    std::vector<Input> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "-r" && i + 1 < argc) {
+            runs = std::max(std::stoi(argv[++i]), 1);
+        } else if (arg == "--json" && i + 1 < argc) {
+            json = argv[++i];
+        } else if (arg.starts_with("-")) {
+            usage(argv[0]);
+            return 1;
+        } else if (fs::is_directory(arg)) {
+            for (auto &entry : fs::recursive_directory_iterator(arg)) {
+                if (entry.is_regular_file() && xnb::is_xnb(entry.path())) {
+                    load(entry.path(), inputs);
+                }
+            }
+        } else {
+            load(arg, inputs);
+        }
+    }
+
+    if (inputs.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::sort(inputs.begin(), inputs.end(),
+              [](auto &a, auto &b) { return a.path < b.path; });
+
+    char corpus[17];
+    std::snprintf(corpus, sizeof(corpus), "%016llx",
+                  (unsigned long long)fingerprint(inputs));
+
+    // The log would be most of what gets timed otherwise.
+    logging::set_level(logging::Off);
+
+    auto output = fs::temp_directory_path() /
+                  ("xnb-bench-" + std::to_string(Clock::now()
+                                                     .time_since_epoch()
+                                                     .count()));
+    fs::create_directories(output);
+
+    ExportOptions options;
+    size_t input_bytes = 0;
+    size_t content_bytes = 0;
+    size_t failures = 0;
+    std::vector<double> times[STAGE_COUNT];
+
+    // The first run warms up the caches and the reader registry and isn't
+    // counted.
+    for (int run = 0; run <= runs; ++run) {
+        double total[STAGE_COUNT] = {};
+        input_bytes = 0;
+        content_bytes = 0;
+        failures = 0;
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            auto bytes = inputs[i].bytes;
+            input_bytes += bytes.size();
+
+            Xnb file;
+            auto start = Clock::now();
+            bool opened = file.open(std::move(bytes)) && file.decompress();
+            auto decompressed = Clock::now();
+            if (opened) {
+                file.read_content();
+            }
+            auto read = Clock::now();
+
+            bool exported =
+                file.asset && export_asset(*file.asset,
+                                           output / std::to_string(i),
+                                           options);
+            auto done = Clock::now();
+
+            content_bytes += file.buffer.data.size();
+            failures += !exported;
+
+            total[Decompress] +=
+                std::chrono::duration<double>(decompressed - start).count();
+            total[Read] += std::chrono::duration<double>(read - decompressed)
+                               .count();
+            total[Export] +=
+                std::chrono::duration<double>(done - read).count();
+        }
+
+        if (run > 0) {
+            for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+                times[stage].push_back(total[stage]);
+            }
+        }
+    }
+
+    std::error_code error;
+    fs::remove_all(output, error);
+    logging::set_level(logging::Debug);
+
+    Stats results[STAGE_COUNT];
+    double megabytes = content_bytes / 1e6;
+
+    // The table moves out of the way of JSON written to stdout.
+    std::FILE *report = json == "-" ? stderr : stdout;
+
+    std::fprintf(report,
+                 "corpus %s: %zu files, %.1f MB in, %.1f MB decompressed,"
+                 " %zu failed, %d runs\n",
+                 corpus, inputs.size(), input_bytes / 1e6, megabytes,
+                 failures, runs);
+    std::fprintf(report, "%-12s %10s %10s %10s %10s\n", "stage", "min ms",
+                 "median ms", "p99 ms", "MB/s");
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        auto &result = results[stage] = summarize(times[stage]);
+        std::fprintf(report, "%-12s %10.2f %10.2f %10.2f %10.1f\n",
+                     STAGE_NAMES[stage], result.min * 1e3,
+                     result.median * 1e3, result.p99 * 1e3,
+                     megabytes / result.median);
+    }
+
+    if (json.empty()) {
+        return 0;
+    }
+
+    // NOTE: Throughput is measured against the decompressed size for every
+    // stage, so the stages can be compared with each other.
+    std::FILE *file = json == "-" ? stdout : std::fopen(json.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not write " << json << "\n";
+        return 1;
+    }
+
+    JsonEmitter out(file);
+    out.begin_object();
+    out.key("corpus");
+    out.string(corpus);
+    out.key("files");
+    out.integer(uint64_t(inputs.size()));
+    out.key("failed");
+    out.integer(uint64_t(failures));
+    out.key("runs");
+    out.integer(int64_t(runs));
+    out.key("input_bytes");
+    out.integer(uint64_t(input_bytes));
+    out.key("content_bytes");
+    out.integer(uint64_t(content_bytes));
+    out.key("stages");
+    out.begin_object();
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        auto &result = results[stage];
+        out.key(STAGE_NAMES[stage]);
+        out.begin_object();
+        out.key("min_ms");
+        out.real(result.min * 1e3);
+        out.key("median_ms");
+        out.real(result.median * 1e3);
+        out.key("p99_ms");
+        out.real(result.p99 * 1e3);
+        out.key("mb_per_s");
+        out.real(megabytes / result.median);
+        out.end_object();
+    }
+
+    out.end_object();
+    out.end_object();
+    bool ok = out.finish();
+
+    if (file != stdout) {
+        ok = std::fclose(file) == 0 && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// Times Buffer::read_7_bit_int against the plain byte at a time loop it
+// replaced, over values spread like the ones in real files: mostly type
+// indices and short string lengths, with the odd long count.
+//
+//   make bin/bench_varint && bin/bench_varint [count]
+
+#include "buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+std::int32_t read_7_bit_loop(Buffer &buffer)
+{
+    int32_t result = 0;
+    int32_t bitsread = 0;
+    int32_t value;
+
+    do {
+        value = buffer.read_byte();
+        result |= (value & 0x7F) << bitsread;
+        bitsread += 7;
+    } while (value & 0x80);
+
+    return result;
+}
+
+void write_7_bit(std::vector<uint8_t> &out, uint32_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+template <typename Read>
+double best_of(int runs, Buffer &buffer, size_t count, int64_t &sum, Read read)
+{
+    double best = 1e9;
+
+    for (int run = 0; run < runs; ++run) {
+        buffer.cursor = 0;
+        int64_t total = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            total += read(buffer);
+        }
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        best = std::min(best, elapsed.count());
+        sum = total;
+    }
+
+    return best;
+}
+
+// Share of values needing 1, 2 and 5 bytes.
+struct Mix
+{
+    const char *name;
+    int one;
+    int two;
+};
+
+const Mix MIXES[] = {
+    {"indices", 100, 0},
+    {"mixed", 80, 15},
+    {"lengths", 40, 50},
+    {"wide", 0, 0},
+};
+
+bool run(const Mix &mix, size_t count)
+{
+    std::mt19937 rng(0x584E42);
+    std::uniform_int_distribution<int> kind(0, 99);
+    std::vector<uint8_t> bytes;
+    std::vector<int32_t> values;
+
+    for (size_t i = 0; i < count; ++i) {
+        int k = kind(rng);
+        uint32_t value = rng() % 0x70000000 + 0x10000000;
+        if (k < mix.one) {
+            value = rng() % 0x80;
+        } else if (k < mix.one + mix.two) {
+            value = rng() % 0x3F80 + 0x80;
+        }
+        values.push_back(int32_t(value));
+        write_7_bit(bytes, value);
+    }
+
+    // Padding keeps the loop from reading off the end.
+    bytes.resize(bytes.size() + 8, 0);
+    Buffer buffer(bytes);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (buffer.read_7_bit_int() != values[i]) {
+            std::printf("%s: mismatch at value %zu\n", mix.name, i);
+            return false;
+        }
+    }
+
+    int64_t loop_sum = 0;
+    int64_t bounded_sum = 0;
+    double loop = best_of(5, buffer, count, loop_sum, read_7_bit_loop);
+    double bounded = best_of(5, buffer, count, bounded_sum, [](Buffer &b) {
+        return b.read_7_bit_int();
+    });
+
+    if (loop_sum != bounded_sum) {
+        std::printf("%s: sums differ\n", mix.name);
+        return false;
+    }
+
+    std::printf("%-8s %5.2f bytes/value  loop %6.2f ns  bounded %6.2f ns\n",
+                mix.name, double(bytes.size() - 8) / count,
+                loop * 1e9 / count, bounded * 1e9 / count);
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 22;
+
+    for (auto &mix : MIXES) {
+        if (!run(mix, count)) {
+            return 1;
+        }
+    }
+    return 0;
+}
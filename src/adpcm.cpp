@@ -0,0 +1,241 @@
+#include "adpcm.hpp"
+
+#include "pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace adpcm
+{
+namespace
+{
+const size_t MAX_CHANNELS = 2;
+const size_t MAX_COEFFICIENTS = 256;
+
+// Header bytes per channel at the start of every block: a predictor
+// index, the initial delta and the first two samples.
+const size_t BLOCK_HEADER_SIZE = 7;
+
+// Blocks handed to a thread at a time.
+const size_t BLOCKS_PER_TASK = 64;
+
+const int ADAPTATION[16] = {230, 230, 230, 230, 307, 409, 512, 614,
+                            768, 614, 512, 409, 307, 230, 230, 230};
+
+const int16_t DEFAULT_COEFFICIENTS[7][2] = {
+    {256, 0}, {512, -256}, {0, 0},      {192, 64},
+    {240, 0}, {460, -208}, {392, -232},
+};
+
+// Both nibbles of a byte, sign extended, with their delta adaptation
+// factors, so the inner loop never has to pick a byte apart.
+struct Nibble
+{
+    int8_t value;
+    uint16_t adaptation;
+};
+
+struct NibbleTable
+{
+    std::array<std::array<Nibble, 2>, 256> entries;
+
+    NibbleTable()
+    {
+        for (int byte = 0; byte < 256; ++byte) {
+            for (int half = 0; half < 2; ++half) {
+                int nibble = half == 0 ? byte >> 4 : byte & 0xF;
+                int value = nibble >= 8 ? nibble - 16 : nibble;
+                entries[byte][half] = {int8_t(value),
+                                       uint16_t(ADAPTATION[nibble])};
+            }
+        }
+    }
+};
+
+const NibbleTable NIBBLES;
+
+struct Format
+{
+    size_t channels = 0;
+    size_t block_align = 0;
+    size_t samples_per_block = 0;
+    std::vector<std::array<int16_t, 2>> coefficients;
+};
+
+int16_t read_i16(const uint8_t *bytes)
+{
+    return int16_t(bytes[0] | (bytes[1] << 8));
+}
+
+bool parse_format(std::span<const uint8_t> header, Format &format)
+{
+    if (header.size() < 16) {
+        return false;
+    }
+
+    format.channels = header[2] | (header[3] << 8);
+    format.block_align = header[12] | (header[13] << 8);
+
+    if (format.channels == 0 || format.channels > MAX_CHANNELS ||
+        format.block_align < BLOCK_HEADER_SIZE * format.channels) {
+        return false;
+    }
+
+    // Every byte after the block header holds two samples, plus the two
+    // samples stored in the header itself.
+    format.samples_per_block =
+        (format.block_align - BLOCK_HEADER_SIZE * format.channels) * 2 /
+            format.channels +
+        2;
+
+    // The extension after cbSize lists the coefficient pairs. Fall back to
+    // the standard set if it is missing.
+    if (header.size() >= 22) {
+        size_t count = std::min<size_t>(header[20] | (header[21] << 8),
+                                        MAX_COEFFICIENTS);
+        for (size_t i = 0; i < count && 26 + i * 4 <= header.size(); ++i) {
+            format.coefficients.push_back({read_i16(&header[22 + i * 4]),
+                                           read_i16(&header[24 + i * 4])});
+        }
+    }
+
+    if (format.coefficients.empty()) {
+        for (auto &pair : DEFAULT_COEFFICIENTS) {
+            format.coefficients.push_back({pair[0], pair[1]});
+        }
+    }
+
+    return true;
+}
+
+struct Channel
+{
+    int coefficient1;
+    int coefficient2;
+    int delta;
+    int sample1;
+    int sample2;
+
+    int16_t expand(Nibble nibble)
+    {
+        int predicted =
+            (sample1 * coefficient1 + sample2 * coefficient2) >> 8;
+        int sample =
+            std::clamp(predicted + nibble.value * delta, -32768, 32767);
+
+        sample2 = sample1;
+        sample1 = sample;
+        delta = std::max((nibble.adaptation * delta) >> 8, 16);
+        return int16_t(sample);
+    }
+};
+
+/*
+ * A block starts with, for each field in turn, one value per channel:
+ *
+ * 	predictor index (1 byte), delta, sample1, sample2 (int16 each)
+ *
+ * sample2 is the first sample of the block, then sample1, then the nibbles
+ * follow with the high nibble first. In stereo, the high nibble belongs to
+ * the left channel and the low nibble to the right.
+ */
+size_t decode_block(const Format &format, std::span<const uint8_t> block,
+                    int16_t *out)
+{
+    size_t channels = format.channels;
+    if (block.size() < BLOCK_HEADER_SIZE * channels) {
+        return 0;
+    }
+
+    Channel state[MAX_CHANNELS];
+    const uint8_t *bytes = block.data();
+
+    for (size_t c = 0; c < channels; ++c) {
+        size_t predictor =
+            std::min<size_t>(bytes[c], format.coefficients.size() - 1);
+        state[c].coefficient1 = format.coefficients[predictor][0];
+        state[c].coefficient2 = format.coefficients[predictor][1];
+        state[c].delta = read_i16(bytes + channels + 2 * c);
+        state[c].sample1 = read_i16(bytes + 3 * channels + 2 * c);
+        state[c].sample2 = read_i16(bytes + 5 * channels + 2 * c);
+    }
+
+    int16_t *start = out;
+    for (size_t c = 0; c < channels; ++c) {
+        *out++ = int16_t(state[c].sample2);
+    }
+    for (size_t c = 0; c < channels; ++c) {
+        *out++ = int16_t(state[c].sample1);
+    }
+
+    auto nibbles = block.subspan(BLOCK_HEADER_SIZE * channels);
+
+    if (channels == 1) {
+        for (uint8_t byte : nibbles) {
+            auto &pair = NIBBLES.entries[byte];
+            *out++ = state[0].expand(pair[0]);
+            *out++ = state[0].expand(pair[1]);
+        }
+    } else {
+        for (uint8_t byte : nibbles) {
+            auto &pair = NIBBLES.entries[byte];
+            *out++ = state[0].expand(pair[0]);
+            *out++ = state[1].expand(pair[1]);
+        }
+    }
+
+    return out - start;
+}
+} // namespace
+
+std::vector<int16_t> decode(std::span<const uint8_t> header,
+                            std::span<const uint8_t> data, ThreadPool *pool)
+{
+    Format format;
+    if (!parse_format(header, format)) {
+        return {};
+    }
+
+    size_t blocks =
+        (data.size() + format.block_align - 1) / format.block_align;
+    size_t block_samples = format.samples_per_block * format.channels;
+
+    // The last block may be cut short, so the output is trimmed to what it
+    // actually held once everything is decoded.
+    std::vector<int16_t> pcm(blocks * block_samples);
+    size_t last_block_samples = 0;
+
+    auto decode_range = [&](size_t task) {
+        size_t first = task * BLOCKS_PER_TASK;
+        size_t last = std::min(first + BLOCKS_PER_TASK, blocks);
+
+        for (size_t i = first; i < last; ++i) {
+            auto block = data.subspan(i * format.block_align);
+            block = block.first(std::min(block.size(), format.block_align));
+
+            size_t samples =
+                decode_block(format, block, &pcm[i * block_samples]);
+            if (i == blocks - 1) {
+                last_block_samples = samples;
+            }
+        }
+    };
+
+    size_t tasks = (blocks + BLOCKS_PER_TASK - 1) / BLOCKS_PER_TASK;
+    if (pool) {
+        pool->parallel_for(tasks, decode_range);
+    } else {
+        for (size_t task = 0; task < tasks; ++task) {
+            decode_range(task);
+        }
+    }
+
+    if (blocks > 0) {
+        pcm.resize((blocks - 1) * block_samples + last_block_samples);
+    }
+    return pcm;
+}
+} // namespace adpcm
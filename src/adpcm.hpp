@@ -0,0 +1,18 @@
+#pragma once
+
+#include "pool.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace adpcm
+{
+// Decodes MS-ADPCM sample data described by an ADPCMWAVEFORMAT header to
+// interleaved 16 bit PCM. Blocks are independent of each other, so they
+// are spread over the pool when one is given. Returns an empty vector if
+// the header isn't usable.
+std::vector<int16_t> decode(std::span<const uint8_t> format,
+                            std::span<const uint8_t> data,
+                            ThreadPool *pool = nullptr);
+} // namespace adpcm
@@ -2,40 +2,71 @@
 
 #include "packing.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <ranges>
 #include <span>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 Buffer::Buffer() : cursor(0) {}
-Buffer::Buffer(std::vector<uint8_t> bytes) : data(bytes), cursor(0) {}
+Buffer::Buffer(std::vector<uint8_t> bytes) : data(std::move(bytes)), cursor(0)
+{
+}
 
-std::uint8_t Buffer::read_byte() { return data[cursor++]; }
-std::uint8_t Buffer::peek_byte() { return data[cursor]; }
+size_t Buffer::start_of(size_t len)
+{
+    if (len > remaining()) {
+        cursor = data.size();
+        throw Overrun();
+    }
+    return cursor;
+}
 
-std::span<uint8_t> Buffer::read(size_t len)
+size_t Buffer::take(size_t len)
 {
-    std::span slice{data.data() + cursor, len};
+    size_t start = start_of(len);
     cursor += len;
-    return slice;
+    return start;
+}
+
+std::uint8_t Buffer::read_byte() { return data[take(1)]; }
+std::uint8_t Buffer::peek_byte() { return data[start_of(1)]; }
+
+size_t Buffer::remaining() const
+{
+    return cursor < data.size() ? data.size() - cursor : 0;
+}
+
+std::span<uint8_t> Buffer::read(size_t len)
+{
+    return std::span(data.data() + take(len), len);
 }
 
 std::span<uint8_t> Buffer::peek(size_t len)
 {
-    return std::span(data.data() + cursor, len);
+    return std::span(data.data() + start_of(len), len);
 }
 
 std::vector<uint8_t> Buffer::copy_out(size_t len)
 {
-    std::vector<uint8_t> buf(len, 0);
-    std::copy(data.begin() + cursor, data.begin() + cursor + len,
-              buf.begin());
-    return buf;
+    auto start = data.begin() + start_of(len);
+    return std::vector<uint8_t>(start, start + len);
 }
 
-void Buffer::seek(int bytes) { cursor += bytes; }
+void Buffer::seek(int bytes)
+{
+    if (bytes < 0) {
+        cursor -= std::min(cursor, size_t(-int64_t(bytes)));
+    } else {
+        take(bytes);
+    }
+}
 
 std::uint32_t Buffer::read_u32(std::endian endianess)
 {
@@ -57,28 +88,93 @@ std::int32_t Buffer::read_i32(std::endian endianess)
     return packing::pack_int(read(4), endianess);
 }
 
-std::int32_t Buffer::read_7_bit_int()
+namespace
 {
-    int32_t result = 0;
-    int32_t bitsread = 0;
-    int32_t value;
-
-    do {
-        value = read_byte();
-        result |= (value & 0x7F) << bitsread;
-        bitsread += 7;
-    } while (value & 0x80);
+// Gathers the 7 bit groups of a little endian varint of up to 5 bytes.
+std::uint32_t gather_7_bit(std::uint64_t bits)
+{
+    return std::uint32_t((bits & 0x7F) | ((bits >> 1) & (0x7F << 7)) |
+                         ((bits >> 2) & (0x7F << 14)) |
+                         ((bits >> 3) & (0x7F << 21)) |
+                         ((bits >> 4) & (0xFull << 28)));
+}
 
-    return result;
+// NOTE: .NET writes at most 5 bytes, the last holding only the top 4
+// bits of the 32.
+bool fits_32_bits(std::uint64_t bits, int length)
+{
+    return length < 5 || ((bits >> 32) & 0xFF) <= 0x0F;
+}
+} // namespace
+
+/*
+ * Values past the first byte are decoded from one 8 byte load: the first
+ * byte without its continuation bit ends the value. A value longer
+ * than 5 bytes or wider than 32 bits can only come from a corrupt file,
+ * and is read as -1 with the cursor moved to the end of the buffer, so
+ * nothing after it gets read as garbage.
+ */
+std::int32_t Buffer::read_long_7_bit_int()
+{
+    if (remaining() >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + cursor, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = __builtin_bswap64(word);
+        }
+
+        std::uint64_t stops = ~word & 0x8080808080808080;
+        int length = (std::countr_zero(stops) + 1) / 8;
+        std::uint64_t bits = word & (~0ull >> (64 - 8 * std::min(length, 5)));
+
+        if (length <= 5 && fits_32_bits(bits, length)) {
+            cursor += length;
+            return std::int32_t(gather_7_bit(bits));
+        }
+    } else {
+        // Near the end of the buffer the bytes are gathered one at a time.
+        std::uint64_t bits = 0;
+        int length = 0;
+        while (length < 5 && length < int(remaining())) {
+            std::uint64_t byte = data[cursor + length];
+            bits |= byte << (8 * length++);
+            if (byte < 0x80) {
+                break;
+            }
+        }
+
+        bool ended = length > 0 && (bits >> (8 * length - 8)) < 0x80;
+        if (ended && fits_32_bits(bits, length)) {
+            cursor += length;
+            return std::int32_t(gather_7_bit(bits));
+        }
+    }
+
+    cursor = data.size();
+    return -1;
 }
 
 std::string Buffer::read_raw_string(size_t len)
 {
-    auto bytes = Buffer::read(len);
-    return std::string(bytes.begin(), bytes.end());
+    return std::string(read_raw_string_view(len));
 }
 
 std::string Buffer::read_string()
 {
     return read_raw_string(read_7_bit_int());
 }
+
+// NOTE: A corrupt length stops at the end of the buffer rather than
+// running past it.
+std::string_view Buffer::read_raw_string_view(size_t len)
+{
+    auto bytes = read(std::min(len, remaining()));
+    return std::string_view(reinterpret_cast<const char *>(bytes.data()),
+                            bytes.size());
+}
+
+std::string_view Buffer::read_string_view()
+{
+    std::int32_t len = read_7_bit_int();
+    return len < 0 ? std::string_view() : read_raw_string_view(len);
+}
@@ -1,12 +1,26 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
+/*
+ * Reads past the end of the data throw Buffer::Overrun rather than reading
+ * whatever follows it, so a truncated or corrupt file can't take a reader
+ * out of bounds whether or not it checks remaining() first. The cursor is
+ * left at the end, so nothing after a bad size gets read as garbage.
+ */
 struct Buffer
 {
+    struct Overrun : std::out_of_range
+    {
+        Overrun() : std::out_of_range("data ends early") {}
+    };
+
     std::vector<uint8_t> data;
     size_t cursor = 0;
 
@@ -17,6 +31,7 @@ struct Buffer
 
     std::uint8_t read_byte();
     std::uint8_t peek_byte();
+    size_t remaining() const;
 
     std::span<uint8_t> read(size_t len);
     std::span<uint8_t> peek(size_t len);
@@ -25,10 +40,29 @@ struct Buffer
     std::uint32_t read_u32(std::endian endianess = std::endian::little);
     std::uint32_t read_u16(std::endian endianess = std::endian::little);
     std::int32_t read_i32(std::endian endianess = std::endian::little);
-    std::int32_t read_7_bit_int();
+
+    // Type indices and most string lengths fit in a single byte, so that
+    // case is inlined into the callers.
+    std::int32_t read_7_bit_int()
+    {
+        if (cursor < data.size() && data[cursor] < 0x80) {
+            return data[cursor++];
+        }
+        return read_long_7_bit_int();
+    }
+    std::int32_t read_long_7_bit_int();
 
     std::uint32_t peek_u16(std::endian endianess = std::endian::little);
 
     std::string read_raw_string(size_t len);
     std::string read_string();
+
+    // Strings viewed in place, without a copy. They stay valid for as long
+    // as the buffer's data does.
+    std::string_view read_raw_string_view(size_t len);
+    std::string_view read_string_view();
+
+    // Where the next len bytes start, once they are known to be there.
+    size_t start_of(size_t len);
+    size_t take(size_t len);
 };
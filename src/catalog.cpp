@@ -0,0 +1,615 @@
+#include "catalog.hpp"
+
+#include "io.hpp"
+#include "pool.hpp"
+#include "readers/texture2d.hpp"
+#include "readers/textures.hpp"
+#include "util.hpp"
+#include "xxh3.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace catalog
+{
+namespace
+{
+void texture_fields(readers::Reader &asset, Entry &entry)
+{
+    if (auto texture = dynamic_cast<readers::Texture2DReader *>(&asset)) {
+        entry.surface_format = texture->surface_format;
+        entry.width = texture->width;
+        entry.height = texture->height;
+        entry.depth = 1;
+        entry.mips = texture->mipcount;
+    } else if (auto volume =
+                   dynamic_cast<readers::Texture3DReader *>(&asset)) {
+        entry.surface_format = volume->surface_format;
+        entry.width = volume->width;
+        entry.height = volume->height;
+        entry.depth = volume->depth;
+        entry.mips = volume->mipcount;
+    } else if (auto cube =
+                   dynamic_cast<readers::TextureCubeReader *>(&asset)) {
+        entry.surface_format = cube->surface_format;
+        entry.width = cube->size;
+        entry.height = cube->size;
+        entry.depth = 6;
+        entry.mips = cube->mipcount;
+    }
+}
+
+// Strings are stored once however many entries use them.
+struct Strings
+{
+    std::string bytes;
+    std::unordered_map<std::string_view, uint32_t> offsets;
+
+    // NOTE: The text is kept as a key as is, so it has to outlive this.
+    uint32_t add(std::string_view text)
+    {
+        auto [found, added] = offsets.try_emplace(text, bytes.size());
+        if (added) {
+            bytes += text;
+            bytes += '\0';
+        }
+        return found->second;
+    }
+};
+
+/*
+ * The catalog file, mapped read only where that is possible and read in
+ * whole otherwise. Everything in it is checked to lie within the file
+ * before it is handed out.
+ */
+struct Catalog
+{
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    std::vector<uint8_t> copy;
+
+    const Header *header = nullptr;
+    const Entry *entries = nullptr;
+    const uint32_t *reader_lists = nullptr;
+    size_t reader_list_count = 0;
+    const char *strings = nullptr;
+    size_t strings_size = 0;
+
+    bool open(const fs::path &path);
+    ~Catalog();
+
+    const char *string(uint32_t offset) const
+    {
+        return offset < strings_size ? strings + offset : "";
+    }
+};
+
+#ifdef _WIN32
+bool map_file(const fs::path &path, Catalog &catalog)
+{
+    if (!io::read_file(path, catalog.copy)) {
+        return false;
+    }
+    catalog.data = catalog.copy.data();
+    catalog.size = catalog.copy.size();
+    return true;
+}
+
+Catalog::~Catalog() {}
+#else
+bool map_file(const fs::path &path, Catalog &catalog)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    catalog.data = static_cast<const uint8_t *>(data);
+    catalog.size = info.st_size;
+    return true;
+}
+
+Catalog::~Catalog()
+{
+    if (data && copy.empty()) {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+}
+#endif
+
+bool Catalog::open(const fs::path &path)
+{
+    if (!map_file(path, *this) || size < sizeof(Header)) {
+        return false;
+    }
+
+    header = reinterpret_cast<const Header *>(data);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION || header->size != size) {
+        return false;
+    }
+
+    // NOTE: Sections are in file order, so each one ends where the next
+    // starts. The strings end with a NUL, so none can run off the end.
+    if (header->entries != sizeof(Header) ||
+        header->reader_lists != header->entries + header->count * 64ull ||
+        header->strings < header->reader_lists ||
+        (header->strings - header->reader_lists) % 4 != 0 ||
+        header->strings > size ||
+        (header->strings < size && data[size - 1] != 0)) {
+        return false;
+    }
+
+    entries = reinterpret_cast<const Entry *>(data + header->entries);
+    reader_lists =
+        reinterpret_cast<const uint32_t *>(data + header->reader_lists);
+    reader_list_count = (header->strings - header->reader_lists) / 4;
+    strings = reinterpret_cast<const char *>(data + header->strings);
+    strings_size = size - header->strings;
+    return true;
+}
+
+enum class Op
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains
+};
+
+enum class Field
+{
+    Path,
+    Type,
+    Target,
+    Reader,
+    Size,
+    ContentSize,
+    Width,
+    Height,
+    Depth,
+    Mips,
+    Format,
+    Version,
+    Hash,
+    Readers,
+    Hidef,
+    Compressed,
+    Readable
+};
+
+const std::pair<const char *, Field> FIELDS[] = {
+    {"path", Field::Path},
+    {"type", Field::Type},
+    {"target", Field::Target},
+    {"reader", Field::Reader},
+    {"size", Field::Size},
+    {"content_size", Field::ContentSize},
+    {"width", Field::Width},
+    {"height", Field::Height},
+    {"depth", Field::Depth},
+    {"mips", Field::Mips},
+    {"format", Field::Format},
+    {"version", Field::Version},
+    {"hash", Field::Hash},
+    {"readers", Field::Readers},
+    {"hidef", Field::Hidef},
+    {"compressed", Field::Compressed},
+    {"readable", Field::Readable}};
+
+// Longer operators first, so "<=" isn't taken for "<".
+const std::pair<const char *, Op> OPS[] = {
+    {"!=", Op::NotEqual}, {"<=", Op::LessEqual}, {">=", Op::GreaterEqual},
+    {"=", Op::Equal},     {"<", Op::Less},       {">", Op::Greater},
+    {"~", Op::Contains}};
+
+struct Filter
+{
+    Field field;
+    Op op;
+    std::string text;
+    uint64_t number = 0;
+
+    bool textual() const { return field <= Field::Reader; }
+};
+
+bool parse_filter(std::string_view spec, Filter &filter)
+{
+    size_t at = spec.find_first_of("!=<>~");
+    if (at == spec.npos) {
+        return false;
+    }
+
+    auto name = spec.substr(0, at);
+    auto field = std::find_if(std::begin(FIELDS), std::end(FIELDS),
+                              [&](auto &f) { return name == f.first; });
+    if (field == std::end(FIELDS)) {
+        return false;
+    }
+    filter.field = field->second;
+
+    auto rest = spec.substr(at);
+    auto op = std::find_if(std::begin(OPS), std::end(OPS), [&](auto &o) {
+        return rest.starts_with(o.first);
+    });
+    if (op == std::end(OPS)) {
+        return false;
+    }
+    filter.op = op->second;
+    filter.text = rest.substr(std::strlen(op->first));
+
+    bool ordering = filter.op != Op::Equal && filter.op != Op::NotEqual &&
+                    filter.op != Op::Contains;
+    if (filter.textual()) {
+        return !ordering;
+    }
+    if (filter.op == Op::Contains || filter.text.empty()) {
+        return false;
+    }
+
+    // Numbers may be written in hex with 0x, hashes for instance.
+    char *end;
+    filter.number = std::strtoull(filter.text.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+bool compare(Op op, std::string_view value, std::string_view wanted)
+{
+    switch (op) {
+    case Op::Equal:
+        return value == wanted;
+    case Op::NotEqual:
+        return value != wanted;
+    default:
+        return value.find(wanted) != value.npos;
+    }
+}
+
+bool compare(Op op, uint64_t value, uint64_t wanted)
+{
+    switch (op) {
+    case Op::Equal:
+        return value == wanted;
+    case Op::NotEqual:
+        return value != wanted;
+    case Op::Less:
+        return value < wanted;
+    case Op::LessEqual:
+        return value <= wanted;
+    case Op::Greater:
+        return value > wanted;
+    default:
+        return value >= wanted;
+    }
+}
+
+const char *type_of(const Catalog &catalog, const Entry &entry)
+{
+    return entry.type == NO_TYPE ? "none" : catalog.string(entry.type);
+}
+
+uint64_t number_of(const Entry &entry, Field field)
+{
+    switch (field) {
+    case Field::Size:
+        return entry.file_size;
+    case Field::ContentSize:
+        return entry.content_size;
+    case Field::Width:
+        return entry.width;
+    case Field::Height:
+        return entry.height;
+    case Field::Depth:
+        return entry.depth;
+    case Field::Mips:
+        return entry.mips;
+    case Field::Format:
+        return entry.surface_format;
+    case Field::Version:
+        return entry.version;
+    case Field::Hash:
+        return entry.hash;
+    case Field::Readers:
+        return entry.reader_count;
+    case Field::Hidef:
+        return (entry.flags & Hidef) != 0;
+    case Field::Compressed:
+        return (entry.flags & Compressed) != 0;
+    default:
+        return (entry.flags & Readable) != 0;
+    }
+}
+
+bool matches(const Catalog &catalog, const Entry &entry,
+             const Filter &filter)
+{
+    switch (filter.field) {
+    case Field::Path:
+        return compare(filter.op, catalog.string(entry.path), filter.text);
+    case Field::Type:
+        return compare(filter.op, type_of(catalog, entry), filter.text);
+    case Field::Target:
+        return compare(filter.op, std::string_view(&entry.target, 1),
+                       filter.text);
+    case Field::Reader: {
+        // Any of the readers matching will do, or none of them for !=.
+        bool negated = filter.op == Op::NotEqual;
+        Op op = negated ? Op::Equal : filter.op;
+        for (uint32_t i = 0; i < entry.reader_count; ++i) {
+            uint32_t index = entry.readers + i;
+            if (index < catalog.reader_list_count &&
+                compare(op, catalog.string(catalog.reader_lists[index]),
+                        filter.text)) {
+                return !negated;
+            }
+        }
+        return negated;
+    }
+    default:
+        return compare(filter.op, number_of(entry, filter.field),
+                       filter.number);
+    }
+}
+
+void print_long(const Catalog &catalog, const Entry &entry)
+{
+    std::printf("%s\t%s\t%ux%ux%u\t%u\t%llu\t%llu\t%016llx\n",
+                catalog.string(entry.path), type_of(catalog, entry),
+                entry.width, entry.height, entry.depth, entry.surface_format,
+                (unsigned long long)entry.file_size,
+                (unsigned long long)entry.content_size,
+                (unsigned long long)entry.hash);
+}
+
+void index_usage()
+{
+    std::cerr << "usage: xnb index [-j <threads>] <catalog>"
+              << " <file.xnb | dir>...\n";
+}
+
+void query_usage()
+{
+    std::cerr << "usage: xnb query [-l] <catalog> [<field><op><value>]...\n"
+              << "  -l       print the type, dimensions, format, sizes and"
+              << " hash as well\n"
+              << "  fields   path type target reader (text: = != ~)\n"
+              << "           size content_size width height depth mips"
+              << " format version\n"
+              << "           hash readers hidef compressed readable"
+              << " (numbers: = != < <= > >=)\n"
+              << "  Every filter has to match. reader matches if any of the"
+              << " file's readers do.\n";
+}
+} // namespace
+
+bool describe(xnb::Context &context, StringInterner &names,
+              const fs::path &path, Record &record)
+{
+    auto &entry = record.entry;
+    record.path = path.string();
+
+    auto document = xnb::open(context, path);
+    if (!document) {
+        return false;
+    }
+    entry.file_size = document->bytes.size();
+    entry.hash = xxh3_64(document->bytes);
+
+    if (auto header = xnb::read_header(*document)) {
+        entry.target = header->target;
+        entry.version = header->version;
+        entry.flags = (header->hidef ? Hidef : 0) |
+                      (header->compressed ? Compressed : 0);
+        entry.content_size = header->content_size;
+
+        if (xnb::decompress(context, *document)) {
+            if (auto asset = xnb::decode(*document)) {
+                entry.flags |= Readable;
+                record.type = readers::type_name((*asset)->type());
+                texture_fields(**asset, entry);
+            }
+        }
+
+        for (auto name : document->xnb.reader_names) {
+            record.readers.push_back(names.intern(name));
+        }
+    }
+
+    xnb::recycle(context, std::move(*document));
+    return true;
+}
+
+bool write(const fs::path &path, const std::vector<Record> &records)
+{
+    std::vector<Entry> entries;
+    std::vector<uint32_t> reader_lists;
+    Strings strings;
+
+    for (auto &record : records) {
+        Entry entry = record.entry;
+        entry.path = strings.add(record.path);
+        entry.type = record.type ? strings.add(record.type) : NO_TYPE;
+        entry.readers = reader_lists.size();
+        entry.reader_count = record.readers.size();
+        for (auto &reader : record.readers) {
+            reader_lists.push_back(strings.add(reader));
+        }
+        entries.push_back(entry);
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.count = entries.size();
+    header.entries = sizeof(Header);
+    header.reader_lists = header.entries + entries.size() * sizeof(Entry);
+    header.strings = header.reader_lists + reader_lists.size() * 4;
+    header.size = header.strings + strings.bytes.size();
+
+    auto bytes = [](auto *data, size_t size) {
+        return io::Bytes(reinterpret_cast<const uint8_t *>(data), size);
+    };
+    return io::write_file(
+        path, {bytes(&header, sizeof(header)),
+               bytes(entries.data(), entries.size() * sizeof(Entry)),
+               bytes(reader_lists.data(), reader_lists.size() * 4),
+               bytes(strings.bytes.data(), strings.bytes.size())});
+}
+
+int index_command(int argc, char **argv)
+{
+    size_t threads = std::thread::hardware_concurrency();
+    std::vector<fs::path> arguments;
+
+    for (int i = 0; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "-j" && i + 1 < argc) {
+            if (!parse_threads(argv[++i], threads)) {
+                index_usage();
+                return 1;
+            }
+        } else if (arg.starts_with("-")) {
+            index_usage();
+            return 1;
+        } else {
+            arguments.push_back(arg);
+        }
+    }
+
+    if (arguments.size() < 2) {
+        index_usage();
+        return 1;
+    }
+
+    std::vector<fs::path> files;
+    for (size_t i = 1; i < arguments.size(); ++i) {
+        auto &input = arguments[i];
+        if (!fs::is_directory(input)) {
+            files.push_back(input);
+            continue;
+        }
+        for (auto &entry : fs::recursive_directory_iterator(input)) {
+            if (entry.is_regular_file() && xnb::is_xnb(entry.path())) {
+                files.push_back(entry.path());
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    // Every file would log its progress otherwise.
+    logging::set_level(logging::Warning);
+
+    xnb::Context context(threads);
+    StringInterner names;
+    std::vector<Record> records(files.size());
+    std::vector<char> found(files.size());
+
+    context.pool.parallel_for(files.size(), [&](size_t i) {
+        found[i] = describe(context, names, files[i], records[i]);
+        if (!found[i]) {
+            WARN("Can't read ", files[i].string());
+        }
+    });
+
+    std::vector<Record> indexed;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (found[i]) {
+            indexed.push_back(std::move(records[i]));
+        }
+    }
+
+    if (!write(arguments[0], indexed)) {
+        WARN("Can't write ", arguments[0].string());
+        return 1;
+    }
+
+    logging::flush();
+    std::cerr << "Indexed " << indexed.size() << " files\n";
+    return indexed.size() == files.size() ? 0 : 1;
+}
+
+int query_command(int argc, char **argv)
+{
+    bool details = false;
+    fs::path path;
+    std::vector<Filter> filters;
+
+    for (int i = 0; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "-l") {
+            details = true;
+        } else if (path.empty() && !arg.starts_with("-")) {
+            path = arg;
+        } else if (Filter filter; parse_filter(arg, filter)) {
+            filters.push_back(std::move(filter));
+        } else {
+            std::cerr << "Bad filter: " << arg << "\n";
+            query_usage();
+            return 1;
+        }
+    }
+
+    if (path.empty()) {
+        query_usage();
+        return 1;
+    }
+
+    Catalog catalog;
+    if (!catalog.open(path)) {
+        std::cerr << "Not a readable catalog: " << path.string() << "\n";
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < catalog.header->count; ++i) {
+        auto &entry = catalog.entries[i];
+        bool wanted = std::all_of(
+            filters.begin(), filters.end(),
+            [&](auto &filter) { return matches(catalog, entry, filter); });
+        if (!wanted) {
+            continue;
+        }
+
+        if (details) {
+            print_long(catalog, entry);
+        } else {
+            std::printf("%s\n", catalog.string(entry.path));
+        }
+    }
+
+    return 0;
+}
+} // namespace catalog
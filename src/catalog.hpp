@@ -0,0 +1,94 @@
+#pragma once
+
+#include "intern.hpp"
+#include "libxnb.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * A catalog of what a tree of XNBs holds, written once by `xnb index`
+ * and mapped into memory by `xnb query` to answer questions like "which
+ * textures are larger than 2048" without opening the XNBs again.
+ *
+ * The file is a header, then an entry per XNB, then a table of reader
+ * lists, then the strings everything refers to. All of it is fixed
+ * width and little endian, so it is used straight from the mapping.
+ */
+namespace catalog
+{
+const char MAGIC[8] = {'X', 'N', 'B', 'C', 'A', 'T', 0, 0};
+const uint32_t VERSION = 2;
+
+// No asset was read.
+const uint32_t NO_TYPE = 0xFFFFFFFF;
+
+enum Flags : uint8_t
+{
+    Hidef = 1,
+    Compressed = 2,
+    Readable = 4 // the primary asset was read
+};
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t entries;      // offsets into the file
+    uint64_t reader_lists; // uint32_t string offsets
+    uint64_t strings;      // NUL terminated
+    uint64_t size;         // of the whole file
+};
+
+struct Entry
+{
+    uint32_t path;    // string offset
+    uint32_t readers; // index of the first in the reader lists
+    uint32_t reader_count;
+    uint32_t surface_format; // textures only, as are the below
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t mips;
+    uint64_t file_size;
+    uint64_t content_size; // once decompressed
+    uint64_t hash;         // xxh3_64 of the file
+    char target;
+    uint8_t version;
+    uint8_t flags;
+    uint8_t reserved;
+
+    // String offset of the asset type's name, or NO_TYPE. Stored by name
+    // so that adding reader types doesn't change what catalogs mean.
+    uint32_t type;
+};
+
+static_assert(sizeof(Header) == 48);
+static_assert(sizeof(Entry) == 64);
+
+// What indexing found out about one file.
+struct Record
+{
+    std::string path;
+    std::vector<std::string_view> readers; // interned
+    const char *type = nullptr;            // readers::type_name, if read
+    Entry entry = {};
+};
+
+// Opens and reads the file for everything an entry records. Returns
+// false if the file couldn't be read at all. Reader names are kept in
+// names, as the same few are used by most files.
+bool describe(xnb::Context &context, StringInterner &names,
+              const std::filesystem::path &path, Record &record);
+
+bool write(const std::filesystem::path &path,
+           const std::vector<Record> &records);
+
+// The commands, given the arguments after their name.
+int index_command(int argc, char **argv);
+int query_command(int argc, char **argv);
+} // namespace catalog
@@ -0,0 +1,126 @@
+#include "dds.hpp"
+
+#include "texture.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace dds
+{
+namespace
+{
+const uint32_t CAPS = 0x1;
+const uint32_t HEIGHT = 0x2;
+const uint32_t WIDTH = 0x4;
+const uint32_t PITCH = 0x8;
+const uint32_t PIXELFORMAT = 0x1000;
+const uint32_t MIPMAPCOUNT = 0x20000;
+const uint32_t LINEARSIZE = 0x80000;
+const uint32_t DEPTH = 0x800000;
+
+const uint32_t ALPHAPIXELS = 0x1;
+const uint32_t ALPHA = 0x2;
+const uint32_t FOURCC = 0x4;
+const uint32_t RGB = 0x40;
+
+const uint32_t CAPS_COMPLEX = 0x8;
+const uint32_t CAPS_TEXTURE = 0x1000;
+const uint32_t CAPS2_CUBEMAP_ALL_FACES = 0xFE00;
+const uint32_t CAPS2_VOLUME = 0x200000;
+
+struct PixelFormat
+{
+    uint32_t flags;
+    char fourcc[4];
+    uint32_t bits;
+    uint32_t masks[4];
+};
+
+PixelFormat pixel_format(int format)
+{
+    switch (format) {
+    case texture::Color:
+        return {RGB | ALPHAPIXELS,
+                {},
+                32,
+                {0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000}};
+    case texture::Bgr565:
+        return {RGB, {}, 16, {0xF800, 0x07E0, 0x001F, 0}};
+    case texture::Bgra5551:
+        return {RGB | ALPHAPIXELS, {}, 16, {0x7C00, 0x03E0, 0x001F, 0x8000}};
+    case texture::Bgra4444:
+        return {RGB | ALPHAPIXELS, {}, 16, {0x0F00, 0x00F0, 0x000F, 0xF000}};
+    case texture::Alpha8:
+        return {ALPHA, {}, 8, {0, 0, 0, 0xFF}};
+    case texture::Dxt1:
+        return {FOURCC, {'D', 'X', 'T', '1'}, 0, {}};
+    case texture::Dxt3:
+        return {FOURCC, {'D', 'X', 'T', '3'}, 0, {}};
+    default:
+        return {FOURCC, {'D', 'X', 'T', '5'}, 0, {}};
+    }
+}
+
+void put_u32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i] = uint8_t(value >> (8 * i));
+    }
+}
+} // namespace
+
+/*
+ * A DDS file is a 4 byte magic and a 124 byte header, followed by the
+ * surfaces: the slices of a volume back to back, or each face in turn.
+ * The header is put together in place and handed to the gathered write
+ * along with the layers, which go out straight from the XNB.
+ */
+bool write(const std::filesystem::path &path, int format, int width,
+           int height, Layout layout, std::span<const io::Bytes> layers)
+{
+    if (!texture::supported(format)) {
+        return false;
+    }
+
+    uint8_t header[128] = {'D', 'D', 'S', ' '};
+    uint32_t flags = CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT;
+    uint32_t pitch;
+
+    if (texture::compressed(format)) {
+        flags |= LINEARSIZE;
+        pitch = texture::image_size(format, width, height);
+    } else {
+        flags |= PITCH;
+        pitch = width * texture::unit_size(format);
+    }
+    if (layout == Layout::Volume) {
+        flags |= DEPTH;
+    }
+
+    put_u32(header + 4, 124);
+    put_u32(header + 8, flags);
+    put_u32(header + 12, height);
+    put_u32(header + 16, width);
+    put_u32(header + 20, pitch);
+    put_u32(header + 24, layout == Layout::Volume ? layers.size() : 0);
+    put_u32(header + 28, 1);
+
+    auto pixels = pixel_format(format);
+    put_u32(header + 76, 32);
+    put_u32(header + 80, pixels.flags);
+    std::memcpy(header + 84, pixels.fourcc, 4);
+    put_u32(header + 88, pixels.bits);
+    for (int i = 0; i < 4; ++i) {
+        put_u32(header + 92 + 4 * i, pixels.masks[i]);
+    }
+
+    put_u32(header + 108, CAPS_TEXTURE | CAPS_COMPLEX);
+    put_u32(header + 112, layout == Layout::Volume ? CAPS2_VOLUME
+                                                   : CAPS2_CUBEMAP_ALL_FACES);
+
+    std::vector<io::Bytes> parts = {io::Bytes(header)};
+    parts.insert(parts.end(), layers.begin(), layers.end());
+    return io::write_file(path, parts);
+}
+} // namespace dds
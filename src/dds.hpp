@@ -0,0 +1,21 @@
+#pragma once
+
+#include "io.hpp"
+
+#include <filesystem>
+#include <span>
+
+namespace dds
+{
+enum class Layout
+{
+    Volume,
+    Cube
+};
+
+// Writes layers of a texture in one of the supported surface formats as
+// they are, without decoding them: the slices of a volume texture, or the
+// six faces of a cube map. Only the top mip level is written.
+bool write(const std::filesystem::path &path, int format, int width,
+           int height, Layout layout, std::span<const io::Bytes> layers);
+} // namespace dds
@@ -0,0 +1,94 @@
+#include "dedup.hpp"
+
+#include "util.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// FNV-1a, 64 bit.
+uint64_t hash(io::Bytes bytes)
+{
+    uint64_t hash = 0xCBF29CE484222325;
+    for (uint8_t byte : bytes) {
+        hash = (hash ^ byte) * 0x100000001B3;
+    }
+    return hash;
+}
+
+// NOTE: A matching hash is only a hint, the file itself has the final say
+// before anything gets linked to it.
+bool same_contents(const fs::path &path, io::Bytes bytes)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> contents{std::istreambuf_iterator<char>(in),
+                                  std::istreambuf_iterator<char>()};
+    return std::equal(contents.begin(), contents.end(), bytes.begin(),
+                      bytes.end());
+}
+
+// NOTE: Outputs of an earlier run may be linked together, so existing
+// files are replaced rather than written over in place, which would change
+// every file linked to them.
+bool replace(const fs::path &path, io::Bytes bytes)
+{
+    std::error_code error;
+    fs::remove(path, error);
+    return io::write_file(path, {bytes});
+}
+
+bool link(const fs::path &original, const fs::path &path)
+{
+    std::error_code error;
+    fs::remove(path, error);
+    fs::create_hard_link(original, path, error);
+
+    if (error) {
+        DEBUG("Can't link ", path.string(), ": ", error.message());
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+bool ContentStore::write(const fs::path &path, io::Bytes bytes)
+{
+    std::pair key{hash(bytes), bytes.size()};
+    std::promise<bool> written;
+    Entry original;
+
+    {
+        std::lock_guard lock(mutex);
+        auto [entry, inserted] =
+            entries.try_emplace(key, Entry{path, written.get_future()});
+        if (!inserted) {
+            original = entry->second;
+        }
+    }
+
+    if (original.path.empty()) {
+        bool ok = replace(path, bytes);
+        written.set_value(ok);
+        return ok;
+    }
+
+    // Whoever got there first may still be writing, so wait for them.
+    if (original.written.get()) {
+        if (original.path == path) {
+            return true;
+        }
+        if (same_contents(original.path, bytes) && link(original.path, path)) {
+            DEBUG("Linked ", path.string(), " to ", original.path.string());
+            return true;
+        }
+    }
+
+    // Fall back on a copy of our own, e.g. across file systems.
+    return replace(path, bytes);
+}
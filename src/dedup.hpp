@@ -0,0 +1,35 @@
+#pragma once
+
+#include "io.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+#include <utility>
+
+/*
+ * Writes files whose contents repeat across a batch, like an effect that
+ * is compiled into every XNB using it. The first file with some contents
+ * is written as usual and later ones are hard linked to it, so those
+ * contents are stored once however many outputs carry them.
+ */
+struct ContentStore
+{
+    struct Entry
+    {
+        std::filesystem::path path;
+
+        // Set once the first file is on disk, to whether writing it worked.
+        std::shared_future<bool> written;
+    };
+
+    std::mutex mutex;
+
+    // Keyed on the hash and size of the contents.
+    std::map<std::pair<uint64_t, size_t>, Entry> entries;
+
+    bool write(const std::filesystem::path &path, io::Bytes bytes);
+};
@@ -0,0 +1,364 @@
+#include "emitter.hpp"
+
+#include "utf8.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+// Output is handed to the file in chunks of about this size.
+const size_t FLUSH_SIZE = 64 * 1024;
+
+bool needs_escape(uint8_t c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+/*
+ * Length of the run at the start of text that can be copied as it is.
+ * Strings in game data rarely need escaping at all, so they are scanned
+ * sixteen bytes at a time for quotes, backslashes and control characters.
+ */
+size_t plain_prefix(const char *text, size_t size)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                         _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+
+        if (unsigned mask = _mm_movemask_epi8(special)) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x1F);
+
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk =
+            vld1q_u8(reinterpret_cast<const uint8_t *>(text + i));
+        uint8x16_t special =
+            vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote),
+                              vceqq_u8(chunk, backslash)),
+                     vcleq_u8(chunk, control));
+
+        // NOTE: Narrowing by four bits leaves a nibble per byte, which
+        // stands in for the movemask NEON doesn't have.
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(special), 4)),
+            0);
+        if (mask) {
+            return i + std::countr_zero(mask) / 4;
+        }
+    }
+#endif
+
+    while (i < size && !needs_escape(text[i])) {
+        ++i;
+    }
+    return i;
+}
+} // namespace
+
+Emitter::Emitter(std::FILE *file) : file(file)
+{
+    out.reserve(FLUSH_SIZE * 2);
+}
+
+void Emitter::put(std::string_view text)
+{
+    out += text;
+
+    if (out.size() >= FLUSH_SIZE) {
+        if (std::fwrite(out.data(), 1, out.size(), file) != out.size()) {
+            failed = true;
+        }
+        out.clear();
+    }
+}
+
+// NOTE: Malformed UTF-8 would make the whole file unreadable to a JSON
+// or YAML parser, so the offending bytes are replaced instead.
+void Emitter::put_quoted(std::string_view text)
+{
+    if (!utf8::valid(text)) {
+        std::string repaired;
+        utf8::repair(text, repaired);
+        put_quoted(repaired);
+        return;
+    }
+
+    out += '"';
+
+    while (!text.empty()) {
+        size_t plain = plain_prefix(text.data(), text.size());
+        out.append(text.data(), plain);
+        text.remove_prefix(plain);
+
+        if (text.empty()) {
+            break;
+        }
+
+        switch (char c = text.front()) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", unsigned(c));
+            out += escape;
+        }
+        text.remove_prefix(1);
+    }
+
+    put("\"");
+}
+
+void Emitter::put_indent(size_t depth)
+{
+    static const std::string_view SPACES = "                                ";
+
+    for (size_t width = depth * 2; width > 0;) {
+        size_t chunk = std::min(width, SPACES.size());
+        put(SPACES.substr(0, chunk));
+        width -= chunk;
+    }
+}
+
+void Emitter::begin_value(bool container)
+{
+    before_value(container);
+    if (!after_key && !frames.empty()) {
+        frames.back().count++;
+    }
+    after_key = false;
+}
+
+void Emitter::begin_object()
+{
+    begin_value(true);
+
+    frames.push_back({true});
+    open(true);
+}
+
+void Emitter::begin_array()
+{
+    begin_value(true);
+
+    frames.push_back({false});
+    open(false);
+}
+
+void Emitter::end_object()
+{
+    Frame frame = frames.back();
+    frames.pop_back();
+    close(frame);
+}
+
+void Emitter::end_array() { end_object(); }
+
+void Emitter::key(std::string_view name)
+{
+    before_key();
+    frames.back().count++;
+
+    put_quoted(name);
+    put(":");
+    after_key = true;
+}
+
+void Emitter::scalar(std::string_view text)
+{
+    begin_value(false);
+
+    put(text);
+    after_scalar();
+}
+
+void Emitter::string(std::string_view value)
+{
+    begin_value(false);
+
+    put_quoted(value);
+    after_scalar();
+}
+
+void Emitter::integer(int64_t value)
+{
+    char text[24];
+    auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+    scalar(std::string_view(text, end - text));
+}
+
+void Emitter::integer(uint64_t value)
+{
+    char text[24];
+    auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+    scalar(std::string_view(text, end - text));
+}
+
+// NOTE: Numbers are written in the shortest form that reads back to the
+// same value, so a float stays 0.1 rather than 0.10000000149011612.
+void Emitter::real(double value)
+{
+    if (!std::isfinite(value)) {
+        scalar(not_finite(value));
+        return;
+    }
+
+    char text[32];
+    auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+    scalar(std::string_view(text, end - text));
+}
+
+void Emitter::real(float value)
+{
+    if (!std::isfinite(value)) {
+        scalar(not_finite(value));
+        return;
+    }
+
+    char text[32];
+    auto end = std::to_chars(text, text + sizeof(text), value).ptr;
+    scalar(std::string_view(text, end - text));
+}
+
+void Emitter::boolean(bool value) { scalar(value ? "true" : "false"); }
+
+void Emitter::null() { scalar("null"); }
+
+bool Emitter::finish()
+{
+    if (std::fwrite(out.data(), 1, out.size(), file) != out.size()) {
+        failed = true;
+    }
+    out.clear();
+    return !failed && std::fflush(file) == 0;
+}
+
+void JsonEmitter::before_key()
+{
+    put(frames.back().count ? ",\n" : "\n");
+    put_indent(frames.size());
+}
+
+void JsonEmitter::before_value(bool)
+{
+    if (after_key) {
+        put(" ");
+    } else if (!frames.empty()) {
+        put(frames.back().count ? ",\n" : "\n");
+        put_indent(frames.size());
+    }
+}
+
+void JsonEmitter::after_scalar()
+{
+    if (frames.empty()) {
+        put("\n");
+    }
+}
+
+void JsonEmitter::open(bool object) { put(object ? "{" : "["); }
+
+void JsonEmitter::close(const Frame &frame)
+{
+    if (frame.count) {
+        put("\n");
+        put_indent(frames.size());
+    }
+    put(frame.object ? "}" : "]");
+
+    if (frames.empty()) {
+        put("\n");
+    }
+}
+
+std::string_view JsonEmitter::not_finite(double) { return "null"; }
+
+// The line holding a container's key or dash is only ended once the
+// container turns out to have something in it.
+void YamlEmitter::first_item()
+{
+    if (frames.back().count == 0 && frames.size() > 1) {
+        put("\n");
+    }
+}
+
+void YamlEmitter::before_key()
+{
+    first_item();
+    put_indent(frames.size() - 1);
+}
+
+void YamlEmitter::before_value(bool container)
+{
+    if (frames.empty()) {
+        return;
+    }
+
+    if (!after_key) {
+        first_item();
+        put_indent(frames.size() - 1);
+        put("-");
+    }
+    if (!container) {
+        put(" ");
+    }
+}
+
+void YamlEmitter::after_scalar() { put("\n"); }
+
+void YamlEmitter::open(bool) {}
+
+void YamlEmitter::close(const Frame &frame)
+{
+    if (frame.count == 0) {
+        put(frames.empty() ? "" : " ");
+        put(frame.object ? "{}\n" : "[]\n");
+    }
+}
+
+std::string_view YamlEmitter::not_finite(double value)
+{
+    if (std::isnan(value)) {
+        return ".nan";
+    }
+    return value < 0 ? "-.inf" : ".inf";
+}
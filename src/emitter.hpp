@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Streams a tree of objects, arrays and scalars out as text. Output
+ * collects in one reused buffer that is flushed to the file whenever it
+ * fills up, so even the largest tables never sit in memory as a whole
+ * document, and nothing is allocated per value once the buffer has grown.
+ *
+ * Derived emitters only decide what goes between tokens. Strings are
+ * always written double quoted with JSON escapes, which YAML reads too.
+ */
+struct Emitter
+{
+    struct Frame
+    {
+        bool object;
+        size_t count = 0;
+    };
+
+    std::FILE *file;
+    std::string out;
+    std::vector<Frame> frames;
+    bool after_key = false;
+    bool failed = false;
+
+    explicit Emitter(std::FILE *file);
+    virtual ~Emitter(){};
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    void key(std::string_view name);
+
+    void string(std::string_view value);
+    void integer(int64_t value);
+    void integer(uint64_t value);
+    void real(double value);
+    void real(float value);
+    void boolean(bool value);
+    void null();
+
+    // Writes out whatever is left. Returns false if any write failed.
+    bool finish();
+
+    void put(std::string_view text);
+    void put_quoted(std::string_view text);
+    void put_indent(size_t depth);
+
+    // Called before every key, and before every value with whether it is
+    // a container. Counts the new item in the enclosing frame.
+    virtual void before_key() = 0;
+    virtual void before_value(bool container) = 0;
+
+    virtual void after_scalar() = 0;
+    virtual void open(bool object) = 0;
+    virtual void close(const Frame &frame) = 0;
+
+    // What to write for NaN and infinities, which JSON has no numbers for.
+    virtual std::string_view not_finite(double value) = 0;
+
+    void begin_value(bool container);
+    void scalar(std::string_view text);
+};
+
+// Pretty printed JSON, indented by two spaces so that documents diff well.
+struct JsonEmitter : Emitter
+{
+    using Emitter::Emitter;
+
+    virtual void before_key();
+    virtual void before_value(bool container);
+    virtual void after_scalar();
+    virtual void open(bool object);
+    virtual void close(const Frame &frame);
+    virtual std::string_view not_finite(double value);
+};
+
+// Block style YAML. Nested containers always start on a line of their
+// own, below the key or dash that holds them.
+struct YamlEmitter : Emitter
+{
+    using Emitter::Emitter;
+
+    virtual void before_key();
+    virtual void before_value(bool container);
+    virtual void after_scalar();
+    virtual void open(bool object);
+    virtual void close(const Frame &frame);
+    virtual std::string_view not_finite(double value);
+
+    void first_item();
+};
@@ -0,0 +1,485 @@
+#include "export.hpp"
+
+#include "adpcm.hpp"
+#include "dds.hpp"
+#include "emitter.hpp"
+#include "gltf.hpp"
+#include "io.hpp"
+#include "readers/effect.hpp"
+#include "readers/soundeffect.hpp"
+#include "readers/spritefont.hpp"
+#include "readers/texture2d.hpp"
+#include "readers/textures.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+#include "wav.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+fs::path with_suffix(const fs::path &stem, const char *suffix)
+{
+    return fs::path(stem.string() + suffix);
+}
+
+bool write_png(const fs::path &path, int width, int height,
+               const uint8_t *rgba, int stride)
+{
+    return stbi_write_png(path.string().c_str(), width, height, 4, rgba,
+                          stride) != 0;
+}
+
+bool check_layer(int format, int width, int height, size_t size)
+{
+    if (!texture::supported(format)) {
+        WARN("Unsupported surface format: ", format);
+        return false;
+    }
+
+    if (width <= 0 || height <= 0 ||
+        size < texture::image_size(format, width, height)) {
+        WARN("Texture data is smaller than its dimensions");
+        return false;
+    }
+
+    return true;
+}
+
+bool check_texture(const readers::Texture2DReader &texture)
+{
+    return check_layer(texture.surface_format, texture.width, texture.height,
+                       texture.bytes.size());
+}
+
+// The texture as RGBA. Color textures already are and are used in place,
+// anything else is decoded into storage.
+const uint8_t *rgba(const readers::Texture2DReader &texture,
+                    std::vector<uint8_t> &storage)
+{
+    if (texture.surface_format == texture::Color) {
+        return texture.bytes.data();
+    }
+
+    storage.resize(size_t(texture.width) * texture.height * 4);
+    texture::decode(texture.surface_format, texture.bytes, texture.width,
+                    texture.height, storage.data());
+    return storage.data();
+}
+
+bool export_texture(readers::Texture2DReader &texture, const fs::path &stem)
+{
+    if (!check_texture(texture)) {
+        return false;
+    }
+
+    std::vector<uint8_t> storage;
+    return write_png(with_suffix(stem, ".png"), texture.width,
+                     texture.height, rgba(texture, storage),
+                     4 * texture.width);
+}
+
+/*
+ * Every glyph is written straight out of the atlas: the image handed to
+ * the PNG writer starts at the glyph's top left pixel and uses the atlas
+ * row stride, so no pixels are copied to cut it out.
+ */
+bool export_glyphs(readers::SpriteFontReader &font, const uint8_t *atlas_rgba,
+                   const fs::path &stem)
+{
+    auto &atlas = *font.texture;
+    int stride = 4 * atlas.width;
+
+    fs::create_directories(stem);
+
+    for (size_t i = 0; i < font.glyphs.size() && i < font.characters.size();
+         ++i) {
+        auto rect = font.glyphs[i];
+
+        if (rect.width <= 0 || rect.height <= 0) {
+            continue;
+        }
+
+        if (rect.x < 0 || rect.y < 0 || rect.x + rect.width > atlas.width ||
+            rect.y + rect.height > atlas.height) {
+            DEBUG("Glyph ", i, " lies outside the atlas");
+            continue;
+        }
+
+        char name[16];
+        std::snprintf(name, sizeof(name), "U+%04X.png",
+                      unsigned(font.characters[i]));
+
+        auto pixels = atlas_rgba + rect.y * stride + rect.x * 4;
+        if (!write_png(stem / name, rect.width, rect.height, pixels,
+                       stride)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Writes the atlas with a descriptor in the BMFont text format, which
+// most engines and font tools can load.
+bool export_bmfont(readers::SpriteFontReader &font, const uint8_t *atlas_rgba,
+                   const fs::path &stem)
+{
+    auto &atlas = *font.texture;
+    auto page = with_suffix(stem, ".png");
+
+    if (!write_png(page, atlas.width, atlas.height, atlas_rgba,
+                   4 * atlas.width)) {
+        return false;
+    }
+
+    std::ofstream out(with_suffix(stem, ".fnt"));
+
+    out << "info face=\"" << stem.filename().string()
+        << "\" size=" << font.line_spacing
+        << " bold=0 italic=0 charset=\"\" unicode=1 stretchH=100 smooth=1"
+        << " aa=1 padding=0,0,0,0 spacing=" << font.spacing << ",0\n";
+    out << "common lineHeight=" << font.line_spacing
+        << " base=" << font.line_spacing << " scaleW=" << atlas.width
+        << " scaleH=" << atlas.height << " pages=1 packed=0\n";
+    out << "page id=0 file=\"" << page.filename().string() << "\"\n";
+
+    size_t count = std::min({font.glyphs.size(), font.cropping.size(),
+                             font.characters.size(), font.kerning.size()});
+    out << "chars count=" << count << "\n";
+
+    // NOTE: XNA advances the pen by the left bearing before drawing the
+    // glyph at its cropping offset, then by the width and right bearing.
+    for (size_t i = 0; i < count; ++i) {
+        auto &glyph = font.glyphs[i];
+        auto &crop = font.cropping[i];
+        auto &kerning = font.kerning[i];
+
+        out << "char id=" << uint32_t(font.characters[i])
+            << " x=" << glyph.x << " y=" << glyph.y
+            << " width=" << glyph.width << " height=" << glyph.height
+            << " xoffset=" << int(kerning.x) + crop.x
+            << " yoffset=" << crop.y << " xadvance="
+            << int(kerning.x + kerning.y + kerning.z + font.spacing)
+            << " page=0 chnl=15\n";
+    }
+
+    return bool(out);
+}
+
+bool export_font(readers::SpriteFontReader &font, const fs::path &stem,
+                 const ExportOptions &options)
+{
+    if (!font.texture || !check_texture(*font.texture)) {
+        return false;
+    }
+
+    std::vector<uint8_t> storage;
+    auto atlas = rgba(*font.texture, storage);
+
+    if (options.split_glyphs) {
+        return export_glyphs(font, atlas, stem);
+    }
+    return export_bmfont(font, atlas, stem);
+}
+
+// A WAVEFORMATEX for 16 bit PCM.
+std::vector<uint8_t> pcm_format(int channels, int sample_rate)
+{
+    std::vector<uint8_t> format;
+    auto put = [&](uint32_t value, int size) {
+        for (int i = 0; i < size; ++i) {
+            format.push_back(uint8_t(value >> (8 * i)));
+        }
+    };
+
+    put(wav::FORMAT_PCM, 2);
+    put(channels, 2);
+    put(sample_rate, 4);
+    put(sample_rate * channels * 2, 4);
+    put(channels * 2, 2);
+    put(16, 2);
+    return format;
+}
+
+bool export_sound(readers::SoundEffectReader &sound, const fs::path &stem,
+                  const ExportOptions &options)
+{
+    if (sound.format.empty()) {
+        WARN("Sound effect has no format");
+        return false;
+    }
+
+    wav::Loop loop;
+    if (sound.loop_length > 0 && sound.loop_start >= 0) {
+        loop = {uint32_t(sound.loop_start), uint32_t(sound.loop_length)};
+    }
+
+    // Few players handle MS-ADPCM, so it is decoded to plain PCM. Loop
+    // points are in samples and carry over unchanged.
+    if (sound.format_tag == wav::FORMAT_ADPCM) {
+        auto pcm = adpcm::decode(sound.format, sound.data, options.pool);
+        if (pcm.empty() && !sound.data.empty()) {
+            WARN("Could not decode MS-ADPCM data");
+            return false;
+        }
+
+        std::span<const uint8_t> bytes(
+            reinterpret_cast<const uint8_t *>(pcm.data()), pcm.size() * 2);
+        return wav::write(with_suffix(stem, ".wav"),
+                          pcm_format(sound.channels, sound.sample_rate),
+                          bytes, loop);
+    }
+
+    return wav::write(with_suffix(stem, ".wav"), sound.format, sound.data,
+                      loop);
+}
+
+// The bytecode goes to disk straight from the decompressed buffer.
+bool export_effect(readers::EffectReader &effect, const fs::path &stem,
+                   const ExportOptions &options)
+{
+    if (effect.bytecode.empty()) {
+        WARN("Effect has no bytecode");
+        return false;
+    }
+
+    auto path = with_suffix(stem, ".fxo");
+    if (options.store) {
+        return options.store->write(path, effect.bytecode);
+    }
+    return io::write_file(path, {effect.bytecode});
+}
+
+// The slices of a volume texture or the faces of a cube map, which share
+// one format and size.
+struct Layers
+{
+    int format;
+    int width;
+    int height;
+    std::vector<io::Bytes> images;
+    dds::Layout layout;
+};
+
+void for_each(ThreadPool *pool, size_t count,
+              const std::function<void(size_t)> &task)
+{
+    if (pool) {
+        pool->parallel_for(count, task);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        task(i);
+    }
+}
+
+/*
+ * Layers are decoded in parallel, each into its own part of one image
+ * with the layers stacked top to bottom. That image is either written as
+ * a whole, or each layer is written out by the task that decoded it.
+ */
+bool export_layers(const Layers &layers, const fs::path &stem,
+                   const ExportOptions &options)
+{
+    for (auto &image : layers.images) {
+        if (!check_layer(layers.format, layers.width, layers.height,
+                         image.size())) {
+            return false;
+        }
+    }
+
+    if (options.layers == LayerLayout::Dds) {
+        return dds::write(with_suffix(stem, ".dds"), layers.format,
+                          layers.width, layers.height, layers.layout,
+                          layers.images);
+    }
+
+    static const char *FACES[] = {"px", "nx", "py", "ny", "pz", "nz"};
+
+    bool split = options.layers == LayerLayout::Split;
+    if (split) {
+        fs::create_directories(stem);
+    }
+
+    size_t count = layers.images.size();
+    size_t stride = 4 * layers.width;
+    size_t size = stride * layers.height;
+    std::vector<uint8_t> strip(size * count);
+    std::atomic<int> failures = 0;
+
+    for_each(options.pool, count, [&](size_t i) {
+        uint8_t *pixels = strip.data() + i * size;
+        texture::decode(layers.format, layers.images[i], layers.width,
+                        layers.height, pixels);
+
+        if (!split) {
+            return;
+        }
+
+        char name[16];
+        if (layers.layout == dds::Layout::Cube) {
+            std::snprintf(name, sizeof(name), "%s.png", FACES[i]);
+        } else {
+            std::snprintf(name, sizeof(name), "%zu.png", i);
+        }
+        if (!write_png(stem / name, layers.width, layers.height, pixels,
+                       stride)) {
+            ++failures;
+        }
+    });
+
+    if (split) {
+        return failures == 0;
+    }
+    return write_png(with_suffix(stem, ".png"), layers.width,
+                     layers.height * count, strip.data(), stride);
+}
+
+bool export_volume(readers::Texture3DReader &texture, const fs::path &stem,
+                   const ExportOptions &options)
+{
+    if (texture.depth <= 0) {
+        WARN("Texture has no slices");
+        return false;
+    }
+
+    // NOTE: The depth comes from the file, so the data is checked to hold
+    // every slice before a layer is set up for each.
+    if (!check_layer(texture.surface_format, texture.width, texture.height,
+                     texture.bytes.size() / texture.depth)) {
+        return false;
+    }
+
+    Layers layers{texture.surface_format, texture.width, texture.height, {},
+                  dds::Layout::Volume};
+    for (int i = 0; i < texture.depth; ++i) {
+        layers.images.push_back(texture.slice(i));
+    }
+    return export_layers(layers, stem, options);
+}
+
+bool export_cube(readers::TextureCubeReader &texture, const fs::path &stem,
+                 const ExportOptions &options)
+{
+    Layers layers{texture.surface_format, texture.size, texture.size,
+                  {texture.faces.begin(), texture.faces.end()},
+                  dds::Layout::Cube};
+    return export_layers(layers, stem, options);
+}
+
+bool export_data(readers::Reader &asset, const fs::path &stem,
+                 const ExportOptions &options)
+{
+    bool yaml = options.data == DataFormat::Yaml;
+    auto path = with_suffix(stem, yaml ? ".yaml" : ".json");
+
+    std::FILE *file = std::fopen(path.string().c_str(), "wb");
+    if (!file) {
+        WARN("Can't open ", path.string());
+        return false;
+    }
+
+    std::unique_ptr<Emitter> out;
+    if (yaml) {
+        out = std::make_unique<YamlEmitter>(file);
+    } else {
+        out = std::make_unique<JsonEmitter>(file);
+    }
+
+    asset.emit(*out);
+    bool ok = out->finish();
+    return std::fclose(file) == 0 && ok;
+}
+} // namespace
+
+bool export_asset(readers::Reader &asset, const fs::path &stem,
+                  const ExportOptions &options)
+{
+    switch (asset.type()) {
+    case readers::Texture2D:
+        return export_texture(static_cast<readers::Texture2DReader &>(asset),
+                              stem);
+    case readers::Texture3D:
+        return export_volume(static_cast<readers::Texture3DReader &>(asset),
+                             stem, options);
+    case readers::TextureCube:
+        return export_cube(static_cast<readers::TextureCubeReader &>(asset),
+                           stem, options);
+    case readers::SpriteFont:
+        return export_font(static_cast<readers::SpriteFontReader &>(asset),
+                           stem, options);
+    case readers::SoundEffect:
+        return export_sound(static_cast<readers::SoundEffectReader &>(asset),
+                            stem, options);
+    case readers::Model:
+        return gltf::write(with_suffix(stem, ".glb"),
+                           static_cast<readers::ModelReader &>(asset));
+    case readers::Primitive:
+    case readers::String:
+    case readers::List:
+    case readers::Array:
+    case readers::Dictionary:
+    case readers::Reflective:
+        return export_data(asset, stem, options);
+    case readers::Effect:
+        return export_effect(static_cast<readers::EffectReader &>(asset),
+                             stem, options);
+    default:
+        WARN("Nothing to export for this asset type");
+        return false;
+    }
+}
+
+std::vector<fs::path> export_paths(readers::Reader &asset, const fs::path &stem,
+                                   const ExportOptions &options)
+{
+    bool split = options.layers == LayerLayout::Split;
+
+    switch (asset.type()) {
+    case readers::Texture2D:
+        return {with_suffix(stem, ".png")};
+    case readers::Texture3D:
+    case readers::TextureCube:
+        if (options.layers == LayerLayout::Dds) {
+            return {with_suffix(stem, ".dds")};
+        }
+        return {split ? stem : with_suffix(stem, ".png")};
+    case readers::SpriteFont:
+        if (options.split_glyphs) {
+            return {stem};
+        }
+        return {with_suffix(stem, ".png"), with_suffix(stem, ".fnt")};
+    case readers::SoundEffect:
+        return {with_suffix(stem, ".wav")};
+    case readers::Model:
+        return {with_suffix(stem, ".glb")};
+    case readers::Primitive:
+    case readers::String:
+    case readers::List:
+    case readers::Array:
+    case readers::Dictionary:
+    case readers::Reflective:
+        return {with_suffix(
+            stem, options.data == DataFormat::Yaml ? ".yaml" : ".json")};
+    case readers::Effect:
+        return {with_suffix(stem, ".fxo")};
+    default:
+        return {};
+    }
+}
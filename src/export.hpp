@@ -0,0 +1,54 @@
+#pragma once
+
+#include "dedup.hpp"
+#include "pool.hpp"
+#include "readers/reader.hpp"
+
+#include <filesystem>
+#include <vector>
+
+// How the slices of a volume texture or the faces of a cube map are
+// written: stacked in one image, as an image each, or as a DDS file.
+enum class LayerLayout
+{
+    Strip,
+    Split,
+    Dds
+};
+
+// The text format data assets (numbers, strings, collections, reflected
+// classes) are written in.
+enum class DataFormat
+{
+    Json,
+    Yaml
+};
+
+struct ExportOptions
+{
+    // Write each glyph of a SpriteFont to its own image instead of a
+    // BMFont descriptor next to the atlas.
+    bool split_glyphs = false;
+
+    LayerLayout layers = LayerLayout::Strip;
+
+    DataFormat data = DataFormat::Json;
+
+    // Used to split up the work within a single asset, when set.
+    ThreadPool *pool = nullptr;
+
+    // Stores outputs that commonly repeat between files only once, when
+    // set. Only used for compiled effects.
+    ContentStore *store = nullptr;
+};
+
+// Writes the asset to files named after stem, with the extension picked
+// by asset type. Returns false if the asset can't be exported.
+bool export_asset(readers::Reader &asset, const std::filesystem::path &stem,
+                  const ExportOptions &options);
+
+// The files export_asset writes for the asset, without writing them. A
+// directory stands for everything in it.
+std::vector<std::filesystem::path>
+export_paths(readers::Reader &asset, const std::filesystem::path &stem,
+             const ExportOptions &options);
@@ -0,0 +1,742 @@
+#include "gltf.hpp"
+
+#include "io.hpp"
+#include "readers/effect.hpp"
+#include "readers/geometry.hpp"
+#include "utf8.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace gltf
+{
+namespace
+{
+using readers::VertexElementFormat;
+using readers::VertexElementUsage;
+
+const int FLOAT = 5126;
+const int UNSIGNED_BYTE = 5121;
+const int UNSIGNED_SHORT = 5123;
+const int UNSIGNED_INT = 5125;
+
+const int ARRAY_BUFFER = 34962;
+const int ELEMENT_ARRAY_BUFFER = 34963;
+
+// glTF requires vertex strides to be a multiple of 4 within this range.
+const size_t MAX_STRIDE = 252;
+
+const uint8_t ZEROS[4] = {};
+
+/*
+ * The BIN chunk is a list of byte ranges rather than one buffer. Geometry
+ * is referenced where it was decoded, only data that had to be converted
+ * is owned here, and everything is written out together at the end.
+ */
+struct Bin
+{
+    std::vector<io::Bytes> parts;
+    std::deque<std::vector<uint8_t>> owned;
+    size_t size = 0;
+
+    size_t add(io::Bytes bytes)
+    {
+        if (size % 4) {
+            parts.push_back(io::Bytes(ZEROS, 4 - size % 4));
+            size += 4 - size % 4;
+        }
+
+        size_t offset = size;
+        parts.push_back(bytes);
+        size += bytes.size();
+        return offset;
+    }
+
+    size_t add(std::vector<uint8_t> bytes)
+    {
+        return add(io::Bytes(owned.emplace_back(std::move(bytes))));
+    }
+
+    void pad()
+    {
+        if (size % 4) {
+            parts.push_back(io::Bytes(ZEROS, 4 - size % 4));
+            size += 4 - size % 4;
+        }
+    }
+};
+
+struct BufferView
+{
+    size_t offset;
+    size_t length;
+    size_t stride;
+    int target;
+};
+
+struct Accessor
+{
+    size_t view;
+    size_t offset;
+    int component;
+    bool normalized;
+    size_t count;
+    const char *type;
+    std::vector<float> min;
+    std::vector<float> max;
+};
+
+// How a vertex element ends up in glTF. Elements that have no direct
+// equivalent are converted to floats.
+struct Mapping
+{
+    std::string name;
+    const char *type = nullptr;
+    int component = FLOAT;
+    bool normalized = false;
+    size_t size = 0;
+    bool convert = false;
+};
+
+bool map_element(const readers::VertexElement &element, Mapping &mapping)
+{
+    auto index = std::to_string(element.usage_index);
+
+    switch (element.usage) {
+    case VertexElementUsage::Position:
+        if (element.format == VertexElementFormat::Vector3 &&
+            element.usage_index == 0) {
+            mapping = {"POSITION", "VEC3", FLOAT, false, 12};
+            return true;
+        }
+        break;
+    case VertexElementUsage::Normal:
+        if (element.format == VertexElementFormat::Vector3 &&
+            element.usage_index == 0) {
+            mapping = {"NORMAL", "VEC3", FLOAT, false, 12};
+            return true;
+        }
+        break;
+    case VertexElementUsage::Tangent:
+        if (element.format == VertexElementFormat::Vector4 &&
+            element.usage_index == 0) {
+            mapping = {"TANGENT", "VEC4", FLOAT, false, 16};
+            return true;
+        }
+        break;
+    case VertexElementUsage::TextureCoordinate:
+        if (element.format == VertexElementFormat::Vector2) {
+            mapping = {"TEXCOORD_" + index, "VEC2", FLOAT, false, 8};
+            return true;
+        }
+        if (element.format == VertexElementFormat::HalfVector2 ||
+            element.format == VertexElementFormat::NormalizedShort2) {
+            mapping = {"TEXCOORD_" + index, "VEC2", FLOAT, false, 8, true};
+            return true;
+        }
+        break;
+    case VertexElementUsage::Color:
+        if (element.format == VertexElementFormat::Color) {
+            mapping = {"COLOR_" + index, "VEC4", UNSIGNED_BYTE, true, 4};
+            return true;
+        }
+        if (element.format == VertexElementFormat::Vector4) {
+            mapping = {"COLOR_" + index, "VEC4", FLOAT, false, 16};
+            return true;
+        }
+        if (element.format == VertexElementFormat::Vector3) {
+            mapping = {"COLOR_" + index, "VEC3", FLOAT, false, 12};
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+float half_to_float(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+    float value;
+
+    if (exponent == 0) {
+        value = std::ldexp(float(mantissa), -24);
+    } else if (exponent == 31) {
+        value = mantissa ? NAN : INFINITY;
+    } else {
+        value = std::ldexp(float(mantissa | 0x400), exponent - 25);
+    }
+    return half & 0x8000 ? -value : value;
+}
+
+// Copies one element out of every vertex into a tightly packed array,
+// converting it to floats if glTF can't take it as it is.
+std::vector<uint8_t> pack_element(const readers::VertexBufferReader &buffer,
+                                  const readers::VertexElement &element,
+                                  const Mapping &mapping)
+{
+    std::vector<uint8_t> packed(buffer.vertex_count * mapping.size);
+    size_t stride = buffer.declaration.stride;
+    const uint8_t *in = buffer.data.data() + element.offset;
+
+    for (size_t v = 0; v < buffer.vertex_count; ++v, in += stride) {
+        uint8_t *out = packed.data() + v * mapping.size;
+
+        if (!mapping.convert) {
+            std::memcpy(out, in, mapping.size);
+            continue;
+        }
+
+        float values[2];
+        for (int i = 0; i < 2; ++i) {
+            uint16_t raw = in[i * 2] | (in[i * 2 + 1] << 8);
+            values[i] = element.format == VertexElementFormat::HalfVector2
+                            ? half_to_float(raw)
+                            : std::max(int16_t(raw) / 32767.0f, -1.0f);
+        }
+        std::memcpy(out, values, sizeof(values));
+    }
+
+    return packed;
+}
+
+void append_escaped(std::string &out, std::string_view text)
+{
+    if (!utf8::valid(text)) {
+        std::string repaired;
+        utf8::repair(text, repaired);
+        append_escaped(out, repaired);
+        return;
+    }
+
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (uint8_t(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out += escape;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void append_number(std::string &out, double value)
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.9g",
+                  std::isfinite(value) ? value : 0.0);
+    out += number;
+}
+
+// Texture names are XNB asset names: relative, without extension, and
+// with Windows separators.
+std::string texture_uri(std::string_view texture)
+{
+    std::string uri;
+    for (char c : texture) {
+        if (c == '\\') {
+            uri += '/';
+        } else if (c == ' ') {
+            uri += "%20";
+        } else {
+            uri += c;
+        }
+    }
+    return uri + ".png";
+}
+
+struct Writer
+{
+    const readers::ModelReader &model;
+
+    Bin bin;
+    std::vector<BufferView> views;
+    std::vector<Accessor> accessors;
+    std::vector<const readers::BasicEffectReader *> materials;
+
+    // Vertex and index buffers are shared between mesh parts, so each gets
+    // its buffer views once.
+    std::map<const void *, size_t> buffer_views;
+    std::map<std::pair<const void *, size_t>, size_t> element_views;
+    std::map<const void *, size_t> material_indices;
+
+    std::string json;
+
+    explicit Writer(const readers::ModelReader &model) : model(model) {}
+
+    size_t add_view(BufferView view)
+    {
+        views.push_back(view);
+        return views.size() - 1;
+    }
+
+    /*
+     * Vertex buffers go into the BIN chunk as they are whenever the stride
+     * is one glTF accepts, so that every attribute is an accessor into the
+     * original interleaved data. Only elements that need converting, or
+     * all of them if the stride doesn't fit, are packed separately.
+     */
+    bool vertex_view(const readers::VertexBufferReader &buffer,
+                     const readers::VertexElement &element,
+                     const Mapping &mapping, size_t &view, size_t &offset,
+                     size_t &stride)
+    {
+        size_t vertex_stride = buffer.declaration.stride;
+        bool direct = !mapping.convert && vertex_stride % 4 == 0 &&
+                      vertex_stride <= MAX_STRIDE && element.offset % 4 == 0;
+
+        if (direct) {
+            auto it = buffer_views.find(&buffer);
+            if (it == buffer_views.end()) {
+                size_t at = bin.add(buffer.data);
+                it = buffer_views
+                         .emplace(&buffer,
+                                  add_view({at, buffer.data.size(),
+                                            vertex_stride, ARRAY_BUFFER}))
+                         .first;
+            }
+            view = it->second;
+            offset = element.offset;
+            stride = vertex_stride;
+            return true;
+        }
+
+        std::pair<const void *, size_t> key{&buffer, element.offset};
+        auto it = element_views.find(key);
+        if (it == element_views.end()) {
+            auto packed = pack_element(buffer, element, mapping);
+            size_t length = packed.size();
+            size_t at = bin.add(std::move(packed));
+            it = element_views
+                     .emplace(key, add_view({at, length, 0, ARRAY_BUFFER}))
+                     .first;
+        }
+        view = it->second;
+        offset = 0;
+        stride = mapping.size;
+        return true;
+    }
+
+    size_t index_view(const readers::IndexBufferReader &buffer)
+    {
+        auto it = buffer_views.find(&buffer);
+        if (it == buffer_views.end()) {
+            size_t at = bin.add(buffer.data);
+            it = buffer_views
+                     .emplace(&buffer, add_view({at, buffer.data.size(), 0,
+                                                 ELEMENT_ARRAY_BUFFER}))
+                     .first;
+        }
+        return it->second;
+    }
+
+    int material(const readers::MeshPart &part)
+    {
+        auto effect = part.effect.as<readers::BasicEffectReader>();
+        if (!effect) {
+            return -1;
+        }
+
+        auto it = material_indices.find(effect);
+        if (it == material_indices.end()) {
+            materials.push_back(effect);
+            it = material_indices.emplace(effect, materials.size() - 1).first;
+        }
+        return int(it->second);
+    }
+
+    // Appends the primitive for a mesh part, or returns false if the part
+    // has no usable geometry.
+    bool primitive(const readers::MeshPart &part, std::string &out)
+    {
+        auto vertices = part.vertex_buffer.as<readers::VertexBufferReader>();
+        auto indices = part.index_buffer.as<readers::IndexBufferReader>();
+
+        // NOTE: The ranges are added up in 64 bits, as the ints they come
+        // from can be anything in a corrupt file.
+        if (!vertices || !indices || part.vertex_offset < 0 ||
+            part.vertex_count <= 0 || part.start_index < 0 ||
+            part.primitive_count <= 0 ||
+            int64_t(part.vertex_offset) + part.vertex_count >
+                int64_t(vertices->vertex_count) ||
+            int64_t(part.start_index) + int64_t(part.primitive_count) * 3 >
+                int64_t(indices->count())) {
+            DEBUG("Skipping mesh part with out of range geometry");
+            return false;
+        }
+
+        out += "{\"attributes\":{";
+        bool first = true;
+
+        for (auto &element : vertices->declaration.elements) {
+            Mapping mapping;
+            if (!map_element(element, mapping) ||
+                element.offset + element_size(element.format) >
+                    vertices->declaration.stride) {
+                continue;
+            }
+
+            size_t view, offset, stride;
+            vertex_view(*vertices, element, mapping, view, offset, stride);
+
+            // Index values are relative to the part's first vertex, which
+            // glTF has no notion of, so the accessor starts there instead.
+            Accessor accessor{view,
+                              offset + part.vertex_offset * stride,
+                              mapping.component,
+                              mapping.normalized,
+                              size_t(part.vertex_count),
+                              mapping.type,
+                              {},
+                              {}};
+
+            if (mapping.name == "POSITION") {
+                auto positions =
+                    vertices->attribute<readers::Vector3>(element.usage);
+                accessor.min = {INFINITY, INFINITY, INFINITY};
+                accessor.max = {-INFINITY, -INFINITY, -INFINITY};
+
+                for (int v = 0; v < part.vertex_count; ++v) {
+                    auto p = positions[part.vertex_offset + v];
+                    float xyz[3] = {p.x, p.y, p.z};
+                    for (int i = 0; i < 3; ++i) {
+                        accessor.min[i] = std::min(accessor.min[i], xyz[i]);
+                        accessor.max[i] = std::max(accessor.max[i], xyz[i]);
+                    }
+                }
+            }
+
+            accessors.push_back(std::move(accessor));
+
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            append_escaped(out, mapping.name);
+            out += ':' + std::to_string(accessors.size() - 1);
+        }
+        out += '}';
+
+        size_t index_size = indices->sixteen_bits ? 2 : 4;
+        accessors.push_back({index_view(*indices),
+                             part.start_index * index_size,
+                             indices->sixteen_bits ? UNSIGNED_SHORT
+                                                   : UNSIGNED_INT,
+                             false,
+                             size_t(part.primitive_count) * 3,
+                             "SCALAR",
+                             {},
+                             {}});
+        out += ",\"indices\":" + std::to_string(accessors.size() - 1);
+
+        if (int index = material(part); index >= 0) {
+            out += ",\"material\":" + std::to_string(index);
+        }
+
+        out += '}';
+        return true;
+    }
+
+    void write_accessors()
+    {
+        json += ",\"accessors\":[";
+        for (size_t i = 0; i < accessors.size(); ++i) {
+            auto &accessor = accessors[i];
+
+            json += i ? ",{" : "{";
+            json += "\"bufferView\":" + std::to_string(accessor.view);
+            json += ",\"byteOffset\":" + std::to_string(accessor.offset);
+            json += ",\"componentType\":" +
+                    std::to_string(accessor.component);
+            if (accessor.normalized) {
+                json += ",\"normalized\":true";
+            }
+            json += ",\"count\":" + std::to_string(accessor.count);
+            json += ",\"type\":\"" + std::string(accessor.type) + '"';
+
+            if (!accessor.min.empty()) {
+                for (auto [name, values] :
+                     {std::pair{"min", &accessor.min},
+                      std::pair{"max", &accessor.max}}) {
+                    json += ",\"" + std::string(name) + "\":[";
+                    for (size_t j = 0; j < values->size(); ++j) {
+                        if (j) {
+                            json += ',';
+                        }
+                        append_number(json, (*values)[j]);
+                    }
+                    json += ']';
+                }
+            }
+            json += '}';
+        }
+        json += ']';
+    }
+
+    void write_views()
+    {
+        json += ",\"bufferViews\":[";
+        for (size_t i = 0; i < views.size(); ++i) {
+            auto &view = views[i];
+
+            json += i ? ",{" : "{";
+            json += "\"buffer\":0,\"byteOffset\":" +
+                    std::to_string(view.offset);
+            json += ",\"byteLength\":" + std::to_string(view.length);
+            if (view.stride) {
+                json += ",\"byteStride\":" + std::to_string(view.stride);
+            }
+            json += ",\"target\":" + std::to_string(view.target) + '}';
+        }
+        json += "],\"buffers\":[{\"byteLength\":" + std::to_string(bin.size) +
+                "}]";
+    }
+
+    // Each BasicEffect becomes a material, with its texture as an image
+    // referenced by URI.
+    void write_materials()
+    {
+        if (materials.empty()) {
+            return;
+        }
+
+        std::string images;
+        size_t image_count = 0;
+        json += ",\"materials\":[";
+
+        for (size_t i = 0; i < materials.size(); ++i) {
+            auto &effect = *materials[i];
+            auto color = effect.diffuse_color;
+
+            json += i ? ",{" : "{";
+            json += "\"pbrMetallicRoughness\":{\"baseColorFactor\":[";
+            float factor[4] = {color.x, color.y, color.z, effect.alpha};
+            for (int j = 0; j < 4; ++j) {
+                append_number(json, std::clamp(factor[j], 0.0f, 1.0f));
+                json += j < 3 ? ',' : ']';
+            }
+
+            if (!effect.texture.empty()) {
+                size_t image = image_count++;
+                json += ",\"baseColorTexture\":{\"index\":" +
+                        std::to_string(image) + '}';
+
+                images += image ? ",{\"uri\":" : "{\"uri\":";
+                append_escaped(images, texture_uri(effect.texture));
+                images += '}';
+            }
+
+            json += ",\"metallicFactor\":0,\"roughnessFactor\":1}";
+            if (effect.alpha < 1) {
+                json += ",\"alphaMode\":\"BLEND\"";
+            }
+            json += '}';
+        }
+        json += ']';
+
+        if (image_count) {
+            json += ",\"images\":[" + images + "],\"textures\":[";
+            for (size_t i = 0; i < image_count; ++i) {
+                json += (i ? ",{\"source\":" : "{\"source\":") +
+                        std::to_string(i) + '}';
+            }
+            json += ']';
+        }
+    }
+
+    /*
+     * Bones become nodes with their transforms. XNA matrices are row major
+     * with row vectors, which is the same memory layout as glTF's column
+     * major matrices with column vectors, so they are written as is. Each
+     * mesh gets a node of its own under its parent bone, as several meshes
+     * can hang off one bone.
+     */
+    void write_nodes(const std::vector<int> &mesh_indices)
+    {
+        size_t bones = model.bones.size();
+        std::vector<std::vector<size_t>> children(bones);
+
+        for (size_t i = 0; i < bones; ++i) {
+            for (int child : model.bones[i].children) {
+                if (child >= 0) {
+                    children[i].push_back(child);
+                }
+            }
+        }
+
+        std::vector<size_t> roots;
+        for (size_t i = 0; i < bones; ++i) {
+            if (model.bones[i].parent < 0) {
+                roots.push_back(i);
+            }
+        }
+
+        std::string mesh_nodes;
+        size_t next = bones;
+
+        for (size_t m = 0; m < model.meshes.size(); ++m) {
+            if (mesh_indices[m] < 0) {
+                continue;
+            }
+
+            int parent = model.meshes[m].parent_bone;
+            if (parent >= 0 && size_t(parent) < bones) {
+                children[parent].push_back(next);
+            } else {
+                roots.push_back(next);
+            }
+
+            mesh_nodes += ",{\"name\":";
+            append_escaped(mesh_nodes, model.meshes[m].name);
+            mesh_nodes += ",\"mesh\":" + std::to_string(mesh_indices[m]) + '}';
+            ++next;
+        }
+
+        json += ",\"nodes\":[";
+        for (size_t i = 0; i < bones; ++i) {
+            auto &bone = model.bones[i];
+
+            json += i ? ",{\"name\":" : "{\"name\":";
+            append_escaped(json, bone.name);
+
+            json += ",\"matrix\":[";
+            for (int j = 0; j < 16; ++j) {
+                if (j) {
+                    json += ',';
+                }
+                append_number(json, bone.transform.m[j]);
+            }
+            json += ']';
+
+            if (!children[i].empty()) {
+                json += ",\"children\":[";
+                for (size_t j = 0; j < children[i].size(); ++j) {
+                    json += (j ? "," : "") + std::to_string(children[i][j]);
+                }
+                json += ']';
+            }
+            json += '}';
+        }
+
+        // Without bones the mesh nodes start the list, if there are any.
+        if (bones) {
+            json += mesh_nodes;
+        } else if (!mesh_nodes.empty()) {
+            json += mesh_nodes.substr(1);
+        }
+        json += "],\"scenes\":[{\"nodes\":[";
+        for (size_t i = 0; i < roots.size(); ++i) {
+            json += (i ? "," : "") + std::to_string(roots[i]);
+        }
+        json += "]}],\"scene\":0";
+    }
+
+    void write()
+    {
+        json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"xnb\"}";
+
+        std::string meshes;
+        std::vector<int> mesh_indices;
+        int mesh_count = 0;
+
+        for (auto &mesh : model.meshes) {
+            std::string primitives;
+            for (auto &part : mesh.parts) {
+                std::string primitive;
+                if (this->primitive(part, primitive)) {
+                    primitives += (primitives.empty() ? "" : ",") + primitive;
+                }
+            }
+
+            if (primitives.empty()) {
+                mesh_indices.push_back(-1);
+                continue;
+            }
+
+            meshes += mesh_count ? ",{\"name\":" : "{\"name\":";
+            append_escaped(meshes, mesh.name);
+            meshes += ",\"primitives\":[" + primitives + "]}";
+            mesh_indices.push_back(mesh_count++);
+        }
+
+        write_nodes(mesh_indices);
+        if (mesh_count) {
+            json += ",\"meshes\":[" + meshes + ']';
+        }
+        write_materials();
+        if (!accessors.empty()) {
+            write_accessors();
+            write_views();
+        }
+        json += '}';
+    }
+};
+
+void put_u32(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(uint8_t(value >> (8 * i)));
+    }
+}
+} // namespace
+
+/*
+ * A .glb is a 12 byte header followed by a JSON chunk and a BIN chunk,
+ * each 4 byte aligned. The BIN chunk is never assembled in memory: its
+ * parts are written from the decoded buffers along with the headers and
+ * the JSON in a single gathered write.
+ */
+bool write(const std::filesystem::path &path,
+           const readers::ModelReader &model)
+{
+    Writer writer{model};
+    writer.write();
+    writer.bin.pad();
+
+    auto &json = writer.json;
+    json.append((4 - json.size() % 4) % 4, ' ');
+
+    bool has_bin = writer.bin.size > 0;
+    size_t total = 12 + 8 + json.size() + (has_bin ? 8 + writer.bin.size : 0);
+
+    std::vector<uint8_t> header;
+    header.insert(header.end(), {'g', 'l', 'T', 'F'});
+    put_u32(header, 2);
+    put_u32(header, total);
+    put_u32(header, json.size());
+    header.insert(header.end(), {'J', 'S', 'O', 'N'});
+
+    std::vector<uint8_t> bin_header;
+    put_u32(bin_header, writer.bin.size);
+    bin_header.insert(bin_header.end(), {'B', 'I', 'N', 0});
+
+    std::vector<io::Bytes> parts = {
+        header, io::Bytes(reinterpret_cast<const uint8_t *>(json.data()),
+                          json.size())};
+    if (has_bin) {
+        parts.push_back(bin_header);
+        parts.insert(parts.end(), writer.bin.parts.begin(),
+                     writer.bin.parts.end());
+    }
+
+    return io::write_file(path, parts);
+}
+} // namespace gltf
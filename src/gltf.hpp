@@ -0,0 +1,13 @@
+#pragma once
+
+#include "readers/model.hpp"
+
+#include <filesystem>
+
+namespace gltf
+{
+// Writes the model as binary glTF 2.0. Textures are referenced by the file
+// names that exporting their own XNBs produces, relative to the model.
+bool write(const std::filesystem::path &path,
+           const readers::ModelReader &model);
+} // namespace gltf
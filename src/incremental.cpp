@@ -0,0 +1,231 @@
+#include "incremental.hpp"
+
+#include "io.hpp"
+#include "xxh3.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace incremental
+{
+namespace
+{
+const char MAGIC[] = "xnb-manifest";
+const char VERSION[] = "1";
+
+std::vector<std::string_view> split(std::string_view line)
+{
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find('\t', start);
+        fields.push_back(line.substr(start, end - start));
+        if (end == std::string_view::npos) {
+            return fields;
+        }
+        start = end + 1;
+    }
+}
+
+template <typename T> bool parse(std::string_view text, T &value, int base)
+{
+    auto end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value, base);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+std::string hex(uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", (unsigned long long)value);
+    return text;
+}
+
+// NOTE: Fields can't hold tabs or line breaks, and entries for paths
+// that do aren't kept. Those files are extracted every time.
+bool storable(std::string_view text)
+{
+    return text.find_first_of("\t\r\n") == std::string_view::npos;
+}
+
+bool storable(const std::string &path, const Entry &entry)
+{
+    if (!storable(path) || !storable(entry.stem)) {
+        return false;
+    }
+    for (auto &output : entry.outputs) {
+        if (!storable(output)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool outputs_exist(const Entry &entry)
+{
+    std::error_code error;
+    for (auto &output : entry.outputs) {
+        if (!fs::exists(output, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+void Manifest::load(const fs::path &path, const std::string &key)
+{
+    this->key = key;
+    entries.clear();
+
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line)) {
+        return;
+    }
+
+    auto header = split(line);
+    if (header.size() != 3 || header[0] != MAGIC || header[1] != VERSION ||
+        header[2] != key) {
+        return;
+    }
+
+    while (std::getline(in, line)) {
+        auto fields = split(line);
+        if (fields.size() < 5) {
+            continue;
+        }
+
+        Entry entry;
+        entry.stem = fields[1];
+        if (!parse(fields[2], entry.size, 10) ||
+            !parse(fields[3], entry.mtime, 10) ||
+            !parse(fields[4], entry.hash, 16)) {
+            continue;
+        }
+        entry.outputs.assign(fields.begin() + 5, fields.end());
+        entries[std::string(fields[0])] = std::move(entry);
+    }
+}
+
+// Written next to the manifest and renamed over it, so a run that is
+// cut short leaves the last complete one.
+bool Manifest::save(const fs::path &path) const
+{
+    auto partial = fs::path(path.string() + ".partial");
+    {
+        std::ofstream out(partial);
+        out << MAGIC << '\t' << VERSION << '\t' << key << '\n';
+
+        for (auto &[input, entry] : entries) {
+            if (!storable(input, entry)) {
+                continue;
+            }
+            out << input << '\t' << entry.stem << '\t' << entry.size << '\t'
+                << entry.mtime << '\t' << hex(entry.hash);
+            for (auto &output : entry.outputs) {
+                out << '\t' << output;
+            }
+            out << '\n';
+        }
+
+        if (!out.flush()) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(partial, path, error);
+    return !error;
+}
+
+const Entry *Manifest::find(const fs::path &input) const
+{
+    auto entry = entries.find(input.string());
+    return entry == entries.end() ? nullptr : &entry->second;
+}
+
+std::string key(const ExportOptions &options,
+                const std::vector<fs::path> &schemas)
+{
+    static const char *LAYERS[] = {"strip", "split", "dds"};
+
+    std::string key = xnb::VERSION;
+    key += options.split_glyphs ? " glyphs" : " bmfont";
+    key += " ";
+    key += LAYERS[int(options.layers)];
+    key += options.data == DataFormat::Yaml ? " yaml" : " json";
+
+    // Schemas go by their contents, as editing one changes what reflected
+    // data is read as.
+    std::vector<uint8_t> bytes;
+    for (auto &schema : schemas) {
+        if (!io::read_file(schema, bytes)) {
+            bytes.clear();
+        }
+        key += " " + hex(xxh3_64(bytes));
+    }
+    return key;
+}
+
+xnb::Result<bool> extract(xnb::Context &context, const fs::path &input,
+                          const fs::path &stem, const Entry *previous,
+                          Entry &entry, stats::Record *stats)
+{
+    // NOTE: A file that can't be looked at gets a size no file has, and
+    // opening it below reports why.
+    std::error_code error;
+    entry = {};
+    entry.stem = stem.string();
+    entry.size = fs::file_size(input, error);
+    entry.mtime = fs::last_write_time(input, error).time_since_epoch().count();
+
+    bool same = previous && previous->stem == entry.stem &&
+                previous->size == entry.size && outputs_exist(*previous);
+    if (same && previous->mtime == entry.mtime) {
+        entry = *previous;
+        return true;
+    }
+
+    auto document = xnb::open(context, input, stats);
+    if (!document) {
+        return unexpected(document.error());
+    }
+
+    // Touched without being changed, like a fresh checkout of the same
+    // files.
+    entry.hash = xxh3_64(document->bytes);
+    if (same && previous->hash == entry.hash) {
+        entry.outputs = previous->outputs;
+        xnb::recycle(context, std::move(*document));
+        return true;
+    }
+
+    if (auto header = xnb::read_header(*document); !header) {
+        return unexpected(header.error());
+    }
+    if (auto done = xnb::decompress(context, *document); !done) {
+        return unexpected(done.error());
+    }
+    auto asset = xnb::decode(*document);
+    if (!asset) {
+        return unexpected(asset.error());
+    }
+    if (auto exported = xnb::export_to(context, *document, stem);
+        !exported) {
+        return unexpected(exported.error());
+    }
+
+    for (auto &path : export_paths(**asset, stem, context.options)) {
+        entry.outputs.push_back(path.string());
+    }
+    xnb::recycle(context, std::move(*document));
+    return false;
+}
+} // namespace incremental
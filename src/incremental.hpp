@@ -0,0 +1,67 @@
+#pragma once
+
+#include "export.hpp"
+#include "libxnb.hpp"
+#include "stats.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Extraction that only redoes the files that changed since the last run.
+ * A manifest keeps what each file looked like when its outputs were
+ * written. A file whose size and modification time are unchanged is
+ * skipped without being read. One that was touched but whose contents
+ * hash the same is skipped once read. Either way its outputs have to
+ * still be there.
+ *
+ * The manifest is a line of "xnb-manifest <version> <key>", then a line
+ * per file of tab separated fields:
+ *
+ *   <path> <stem> <size> <mtime> <xxh3_64 in hex> <output>...
+ *
+ * The key covers whatever besides the file changes its outputs: the
+ * version of the tool, the export options and the schemas loaded. All of
+ * the entries are dropped when it differs.
+ */
+namespace incremental
+{
+struct Entry
+{
+    std::string stem;
+    uintmax_t size = 0;
+    int64_t mtime = 0; // in ticks of the file clock
+    uint64_t hash = 0; // xxh3_64 of the file
+    std::vector<std::string> outputs;
+};
+
+struct Manifest
+{
+    std::string key;
+    std::map<std::string, Entry> entries; // by input path
+
+    // Keeps the entries only if they were written under the key. A
+    // missing or unreadable manifest is an empty one.
+    void load(const std::filesystem::path &path, const std::string &key);
+    bool save(const std::filesystem::path &path) const;
+
+    const Entry *find(const std::filesystem::path &input) const;
+};
+
+std::string key(const ExportOptions &options,
+                const std::vector<std::filesystem::path> &schemas);
+
+/*
+ * Extracts the file unless the previous entry, when given, shows its
+ * outputs are up to date. Fills in the entry for the file either way.
+ * Returns whether the file was skipped.
+ */
+xnb::Result<bool> extract(xnb::Context &context,
+                          const std::filesystem::path &input,
+                          const std::filesystem::path &stem,
+                          const Entry *previous, Entry &entry,
+                          stats::Record *stats = nullptr);
+} // namespace incremental
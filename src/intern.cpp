@@ -0,0 +1,55 @@
+#include "intern.hpp"
+
+#include <cstring>
+#include <functional>
+
+namespace
+{
+const size_t BLOCK_SIZE = 64 * 1024;
+} // namespace
+
+std::string_view StringInterner::Shard::store(std::string_view text)
+{
+    // Strings too big to pack get a block of their own, so they don't
+    // waste the rest of the current one.
+    if (text.size() > BLOCK_SIZE / 4) {
+        auto &block = blocks.emplace_back(new char[text.size()]);
+        std::memcpy(block.get(), text.data(), text.size());
+        return std::string_view(block.get(), text.size());
+    }
+
+    if (!current || used + text.size() > BLOCK_SIZE) {
+        current = blocks.emplace_back(new char[BLOCK_SIZE]).get();
+        used = 0;
+    }
+
+    char *copy = current + used;
+    std::memcpy(copy, text.data(), text.size());
+    used += text.size();
+    return std::string_view(copy, text.size());
+}
+
+std::string_view StringInterner::intern(std::string_view text)
+{
+    size_t hash = std::hash<std::string_view>{}(text);
+    auto &shard = shards[(hash >> 8) % SHARDS];
+
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.strings.find(text); it != shard.strings.end()) {
+        return *it;
+    }
+
+    auto copy = shard.store(text);
+    shard.strings.insert(copy);
+    return copy;
+}
+
+size_t StringInterner::size()
+{
+    size_t count = 0;
+    for (auto &shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        count += shard.strings.size();
+    }
+    return count;
+}
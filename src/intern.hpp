@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * Keeps one copy of every distinct string handed to it, for strings that
+ * have to outlive the file they were read from. Game data repeats the
+ * same keys and asset names over and over, so after the first time a
+ * string costs a lookup rather than an allocation.
+ *
+ * Copies are packed into large blocks that live as long as the interner.
+ * It is safe to use from several threads: strings are spread over shards
+ * by hash, each with a lock of its own.
+ */
+struct StringInterner
+{
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_set<std::string_view> strings;
+        std::vector<std::unique_ptr<char[]>> blocks;
+
+        // The block strings are currently packed into.
+        char *current = nullptr;
+        size_t used = 0;
+
+        std::string_view store(std::string_view text);
+    };
+
+    static constexpr size_t SHARDS = 16;
+    std::array<Shard, SHARDS> shards;
+
+    // Returns the interned copy of text, which stays valid for the
+    // lifetime of the interner.
+    std::string_view intern(std::string_view text);
+
+    size_t size();
+};
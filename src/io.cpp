@@ -0,0 +1,97 @@
+#include "io.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+#endif
+
+namespace io
+{
+bool read_file(const std::filesystem::path &path,
+               std::vector<uint8_t> &bytes)
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+
+    std::FILE *file = std::fopen(path.string().c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    bytes.resize(size);
+    size_t read = std::fread(bytes.data(), 1, size, file);
+    std::fclose(file);
+    return read == size;
+}
+
+#ifdef _WIN32
+bool write_file(const std::filesystem::path &path,
+                std::span<const Bytes> parts)
+{
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    for (auto part : parts) {
+        out.write(reinterpret_cast<const char *>(part.data()), part.size());
+    }
+    return bool(out);
+}
+#else
+bool write_file(const std::filesystem::path &path,
+                std::span<const Bytes> parts)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::vector<iovec> vectors;
+    for (auto part : parts) {
+        if (!part.empty()) {
+            vectors.push_back({const_cast<uint8_t *>(part.data()),
+                               part.size()});
+        }
+    }
+
+    // writev may stop short, so skip past whatever made it out and retry
+    // with the rest.
+    auto next = vectors.begin();
+    while (next != vectors.end()) {
+        int count = int(std::min<size_t>(vectors.end() - next, IOV_MAX));
+        ssize_t written = writev(fd, &*next, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return false;
+        }
+
+        while (next != vectors.end() && size_t(written) >= next->iov_len) {
+            written -= next->iov_len;
+            ++next;
+        }
+        if (next != vectors.end()) {
+            next->iov_base = static_cast<uint8_t *>(next->iov_base) + written;
+            next->iov_len -= written;
+        }
+    }
+
+    return close(fd) == 0;
+}
+#endif
+} // namespace io
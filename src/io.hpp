@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+namespace io
+{
+using Bytes = std::span<const uint8_t>;
+
+// Reads the whole file into bytes, reusing the storage it already has.
+bool read_file(const std::filesystem::path &path,
+               std::vector<uint8_t> &bytes);
+
+// Writes the parts back to back with a single gathered write, so large
+// payloads go to disk straight from wherever they were decoded.
+bool write_file(const std::filesystem::path &path,
+                std::span<const Bytes> parts);
+
+inline bool write_file(const std::filesystem::path &path,
+                       std::initializer_list<Bytes> parts)
+{
+    return write_file(path, std::span(parts.begin(), parts.size()));
+}
+} // namespace io
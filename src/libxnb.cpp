@@ -0,0 +1,258 @@
+#include "libxnb.hpp"
+
+#include "io.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace xnb
+{
+namespace
+{
+Unexpected<Error> fail(Errc code, const Document &document,
+                       const std::string &what)
+{
+    return unexpected(Error{code, document.name + ": " + what});
+}
+
+/*
+ * Runs a step that returns whether it worked, turning anything it throws
+ * into an error of the step's kind. Sizes come from the file, so a
+ * corrupt one can ask for more memory than there is. Buffers throw on
+ * reads past their end, and the standard library on a few other kinds of
+ * bad input.
+ */
+template <typename F>
+Result<bool> attempt(Errc code, const Document &document, F step)
+{
+    try {
+        return step();
+    } catch (const std::bad_alloc &) {
+        return fail(code, document, "out of memory");
+    } catch (const std::exception &error) {
+        return fail(code, document, error.what());
+    }
+}
+} // namespace
+
+Context::Context(size_t threads) : pool(threads)
+{
+    options.pool = &pool;
+}
+
+Context::~Context()
+{
+    for (auto state : lzx_states) {
+        LZXteardown(state);
+    }
+}
+
+LZXstate *Context::acquire_lzx()
+{
+    {
+        std::lock_guard lock(mutex);
+        if (!lzx_states.empty()) {
+            auto state = lzx_states.back();
+            lzx_states.pop_back();
+            return state;
+        }
+    }
+    return LZXinit(16);
+}
+
+void Context::release_lzx(LZXstate *state)
+{
+    std::lock_guard lock(mutex);
+    lzx_states.push_back(state);
+}
+
+std::vector<uint8_t> Context::acquire_bytes()
+{
+    std::lock_guard lock(mutex);
+    if (spare_bytes.empty()) {
+        return {};
+    }
+    auto bytes = std::move(spare_bytes.back());
+    spare_bytes.pop_back();
+    return bytes;
+}
+
+// NOTE: Only as many are kept as there are threads, which is as many
+// files as can be in flight at once.
+void Context::release_bytes(std::vector<uint8_t> bytes)
+{
+    std::lock_guard lock(mutex);
+    if (spare_bytes.size() < pool.size()) {
+        bytes.clear();
+        spare_bytes.push_back(std::move(bytes));
+    }
+}
+
+Result<Document> open(Context &context, const fs::path &path,
+                      stats::Record *stats)
+{
+    Document document;
+    document.name = path.string();
+    document.bytes = context.acquire_bytes();
+    document.xnb.stats = stats;
+
+    Result<bool> read = false;
+    {
+        stats::Timer timer(stats, stats::Load);
+        read = attempt(Errc::Io, document,
+                       [&] { return io::read_file(path, document.bytes); });
+    }
+    if (!read) {
+        return unexpected(read.error());
+    }
+    if (!*read) {
+        return fail(Errc::Io, document, "can't read the file");
+    }
+    return document;
+}
+
+Result<Document> open(std::vector<uint8_t> bytes, std::string name,
+                      stats::Record *stats)
+{
+    Document document;
+    document.name = std::move(name);
+    document.bytes = std::move(bytes);
+    document.xnb.stats = stats;
+    return document;
+}
+
+Result<Header> read_header(Document &document)
+{
+    auto &xnb = document.xnb;
+    if (!xnb.open(std::move(document.bytes))) {
+        return fail(Errc::NotXnb, document, "not an XNB file");
+    }
+
+    Header header;
+    header.target = xnb.target;
+    header.version = xnb.format_version;
+    header.hidef = xnb.hidef;
+    header.compressed = xnb.compressed;
+    header.file_size = xnb.filesize;
+    header.content_size =
+        xnb.compressed ? xnb.decompressed_filesize : xnb.buffer.remaining();
+    return header;
+}
+
+Result<void> decompress(Context &context, Document &document)
+{
+    auto &xnb = document.xnb;
+    if (!xnb.valid) {
+        return fail(Errc::NotXnb, document, "the header wasn't read");
+    }
+
+    xnb.lzx = context.acquire_lzx();
+    auto ok = attempt(Errc::Corrupt, document,
+                      [&] { return xnb.decompress(); });
+    context.release_lzx(xnb.lzx);
+    xnb.lzx = nullptr;
+
+    if (!ok) {
+        return unexpected(ok.error());
+    }
+    if (!*ok) {
+        return fail(Errc::Corrupt, document, "compressed data is corrupt");
+    }
+    return {};
+}
+
+Result<readers::Reader *> decode(Document &document)
+{
+    auto &xnb = document.xnb;
+    if (xnb.asset) {
+        return xnb.asset.get();
+    }
+
+    auto ok = attempt(Errc::Unreadable, document,
+                      [&] { return xnb.read_content(); });
+    if (!ok) {
+        return unexpected(ok.error());
+    }
+    if (!*ok) {
+        return fail(Errc::Unreadable, document,
+                    "can't read the primary asset");
+    }
+    return xnb.asset.get();
+}
+
+Result<void> export_to(Context &context, Document &document,
+                       const fs::path &stem)
+{
+    auto asset = decode(document);
+    if (!asset) {
+        return unexpected(asset.error());
+    }
+
+    if (stem.has_parent_path()) {
+        std::error_code error;
+        fs::create_directories(stem.parent_path(), error);
+    }
+
+    stats::Timer timer(document.xnb.stats, stats::Export);
+    auto ok = attempt(Errc::ExportFailed, document, [&] {
+        return export_asset(**asset, stem, context.options);
+    });
+    if (!ok) {
+        return unexpected(ok.error());
+    }
+    if (!*ok) {
+        return fail(Errc::ExportFailed, document,
+                    "can't export to " + stem.string());
+    }
+    return {};
+}
+
+bool is_xnb(const fs::path &path)
+{
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return extension == ".xnb";
+}
+
+Result<Document> load(Context &context, const fs::path &path,
+                      stats::Record *stats)
+{
+    auto document = open(context, path, stats);
+    if (!document) {
+        return document;
+    }
+
+    if (auto header = read_header(*document); !header) {
+        return unexpected(header.error());
+    }
+    if (auto done = decompress(context, *document); !done) {
+        return unexpected(done.error());
+    }
+    if (auto asset = decode(*document); !asset) {
+        return unexpected(asset.error());
+    }
+    return document;
+}
+
+// NOTE: The objects read may still point into the bytes, so they go
+// before the bytes are handed out again.
+void recycle(Context &context, Document &&document)
+{
+    std::vector<uint8_t> bytes;
+    {
+        Document done = std::move(document);
+        bytes = std::move(done.xnb.buffer.data);
+    }
+    context.release_bytes(std::move(bytes));
+}
+} // namespace xnb
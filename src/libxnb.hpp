@@ -0,0 +1,117 @@
+#pragma once
+
+#include "dedup.hpp"
+#include "export.hpp"
+#include "lzx.h"
+#include "pool.hpp"
+#include "result.hpp"
+#include "stats.hpp"
+#include "xnb.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * The library the command line is built on, for programs that embed it.
+ * A file goes through open, read_header, decompress, decode and
+ * export_to in that order, or load for all but the last. Nothing throws:
+ * every step returns its value or an Error. The context keeps what is
+ * expensive to set up between files.
+ */
+namespace xnb
+{
+// Bumped whenever the outputs for some input change, as incremental runs
+// only redo the files whose outputs were written by another version.
+const char VERSION[] = "1.0";
+
+enum class Errc
+{
+    Io,          // the file couldn't be read
+    NotXnb,      // the header is wrong
+    Corrupt,     // the compressed data doesn't decompress
+    Unreadable,  // the objects in it can't be read
+    ExportFailed // the outputs couldn't be written
+};
+
+struct Error
+{
+    Errc code;
+    std::string message;
+};
+
+template <typename T> using Result = Expected<T, Error>;
+
+/*
+ * Shared by every file going through the library. It may be used from
+ * several threads at once, the pool's included.
+ */
+struct Context
+{
+    ThreadPool pool;
+    ContentStore store;
+    ExportOptions options;
+
+    std::mutex mutex;
+    std::vector<LZXstate *> lzx_states;
+    std::vector<std::vector<uint8_t>> spare_bytes;
+
+    explicit Context(size_t threads = std::thread::hardware_concurrency());
+    ~Context();
+
+    // LZX states are reset and handed out again, rather than each file
+    // allocating one and its window.
+    LZXstate *acquire_lzx();
+    void release_lzx(LZXstate *state);
+
+    // Storage for reading files into, kept from files that are done with.
+    std::vector<uint8_t> acquire_bytes();
+    void release_bytes(std::vector<uint8_t> bytes);
+};
+
+struct Header
+{
+    char target = 0;
+    int version = 0;
+    bool hidef = false;
+    bool compressed = false;
+    size_t file_size = 0;
+    size_t content_size = 0; // once decompressed
+};
+
+// A file on its way through the steps below.
+struct Document
+{
+    std::string name;           // for messages
+    std::vector<uint8_t> bytes; // until the header is read
+    Xnb xnb;
+};
+
+Result<Document> open(Context &context, const std::filesystem::path &path,
+                      stats::Record *stats = nullptr);
+Result<Document> open(std::vector<uint8_t> bytes, std::string name = {},
+                      stats::Record *stats = nullptr);
+
+Result<Header> read_header(Document &document);
+Result<void> decompress(Context &context, Document &document);
+
+// The primary asset, owned by the document.
+Result<readers::Reader *> decode(Document &document);
+
+Result<void> export_to(Context &context, Document &document,
+                       const std::filesystem::path &stem);
+
+// Whether the path names an XNB file, going by its extension.
+bool is_xnb(const std::filesystem::path &path);
+
+// Opens the file and reads everything in it.
+Result<Document> load(Context &context, const std::filesystem::path &path,
+                      stats::Record *stats = nullptr);
+
+// Gives the storage of a document that is done with back to the context.
+void recycle(Context &context, Document &&document);
+} // namespace xnb
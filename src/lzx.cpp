@@ -87,6 +87,8 @@ struct LZXstate
     LONG intel_filesize;   /* magic header value used for transform   */
     LONG intel_curpos;     /* current offset in transform space       */
     int intel_started;     /* have we seen any translatable data yet? */
+    struct LZXcounters *counters; /* totals to add to, if any            */
+    struct LZXdetail *detail;     /* and in more detail, if built for it */
 
     LZX_DECLARE_TABLE(PRETREE);
     LZX_DECLARE_TABLE(MAINTREE);
@@ -206,6 +208,8 @@ struct LZXstate *LZXinit(int window)
     pState->intel_curpos = 0;
     pState->intel_started = 0;
     pState->window_posn = 0;
+    pState->counters = NULL;
+    pState->detail = NULL;
 
     /* initialise tables to 0 (because deltas will be applied to them) */
     for (i = 0; i < LZX_MAINTREE_MAXSYMBOLS; i++) {
@@ -251,6 +255,23 @@ int LZXreset(struct LZXstate *pState)
     return DECR_OK;
 }
 
+void LZXsetcounters(struct LZXstate *pState, struct LZXcounters *counters)
+{
+    pState->counters = counters;
+}
+
+int LZXsetdetail(struct LZXstate *pState, struct LZXdetail *detail)
+{
+#ifdef XNB_LZX_STATS
+    pState->detail = detail;
+    return 1;
+#else
+    (void)pState;
+    (void)detail;
+    return 0;
+#endif
+}
+
 /* Bitstream reading macros:
  *
  * INIT_BITSTREAM    should be used first to set up the system
@@ -264,6 +285,10 @@ int LZXreset(struct LZXstate *pState)
  * LSB as a free source of zeroes. This avoids having to mask any bits.
  * So we have to know the bit width of the bitbuffer variable. This is
  * sizeof(ULONG) * 8, also defined as ULONG_BITS
+ *
+ * Past endinp the input reads as zeroes, so a truncated or corrupt block
+ * can't make the decoder read beyond it. inpos still moves on, which is
+ * what the buffer exhaustion checks go by.
  */
 
 /* number of bits in ULONG. Note: This must be at multiple of 16, and at
@@ -282,8 +307,12 @@ int LZXreset(struct LZXstate *pState)
 
 #define ENSURE_BITS(n)                                                    \
     while (bitsleft < (n)) {                                              \
-        bitbuf |= ((inpos[1] << 8) | inpos[0])                            \
-                  << (ULONG_BITS - 16 - bitsleft);                        \
+        if (endinp - inpos >= 2) {                                        \
+            bitbuf |= ((inpos[1] << 8) | inpos[0])                        \
+                      << (ULONG_BITS - 16 - bitsleft);                    \
+        } else if (endinp - inpos == 1) {                                 \
+            bitbuf |= ULONG(inpos[0]) << (ULONG_BITS - 16 - bitsleft);    \
+        }                                                                 \
         bitsleft += 16;                                                   \
         inpos += 2;                                                       \
     }
@@ -317,14 +346,19 @@ int LZXreset(struct LZXstate *pState)
     }
 
 /* READ_HUFFSYM(tablename, var) decodes one huffman symbol from the
- * bitstream using the stated table and puts it in var.
+ * bitstream using the stated table and puts it in var. HUFFSYM_LONG and
+ * HUFFSYM_DONE count symbols for LZXdetail where it is collected.
  */
+#define HUFFSYM_LONG(tbl)
+#define HUFFSYM_DONE(tbl)
+
 #define READ_HUFFSYM(tbl, var)                                            \
     do {                                                                  \
         ENSURE_BITS(16);                                                  \
         hufftbl = SYMTABLE(tbl);                                          \
         if ((i = hufftbl[PEEK_BITS(TABLEBITS(tbl))]) >=                   \
             MAXSYMBOLS(tbl)) {                                            \
+            HUFFSYM_LONG(tbl);                                            \
             j = 1 << (ULONG_BITS - TABLEBITS(tbl));                       \
             do {                                                          \
                 j >>= 1;                                                  \
@@ -337,6 +371,7 @@ int LZXreset(struct LZXstate *pState)
         }                                                                 \
         j = LENTABLE(tbl)[(var) = i];                                     \
         REMOVE_BITS(j);                                                   \
+        HUFFSYM_DONE(tbl);                                                \
     } while (0)
 
 /* READ_LENGTHS(tablename, first, last) reads in code lengths for symbols
@@ -348,6 +383,7 @@ int LZXreset(struct LZXstate *pState)
         lb.bb = bitbuf;                                                   \
         lb.bl = bitsleft;                                                 \
         lb.ip = inpos;                                                    \
+        lb.end = endinp;                                                  \
         if (lzx_read_lens(pState, LENTABLE(tbl), (first), (last), &lb)) { \
             return DECR_ILLEGALDATA;                                      \
         }                                                                 \
@@ -466,8 +502,23 @@ struct lzx_bits
     ULONG bb;
     int bl;
     UBYTE *ip;
+    UBYTE *end;
 };
 
+/* tree lengths are read rarely enough to just check for a detail */
+#ifdef XNB_LZX_STATS
+#undef HUFFSYM_LONG
+#undef HUFFSYM_DONE
+#define HUFFSYM_LONG(tbl)                                                 \
+    if (pState->detail) {                                                 \
+        pState->detail->long_codes[LZX_TREE_##tbl]++;                     \
+    }
+#define HUFFSYM_DONE(tbl)                                                 \
+    if (pState->detail) {                                                 \
+        pState->detail->symbols[LZX_TREE_##tbl]++;                        \
+    }
+#endif
+
 static int lzx_read_lens(struct LZXstate *pState, UBYTE *lens, ULONG first,
                          ULONG last, struct lzx_bits *lb)
 {
@@ -477,6 +528,7 @@ static int lzx_read_lens(struct LZXstate *pState, UBYTE *lens, ULONG first,
     ULONG bitbuf = lb->bb;
     int bitsleft = lb->bl;
     UBYTE *inpos = lb->ip;
+    UBYTE *endinp = lb->end;
     UWORD *hufftbl;
 
     for (x = 0; x < 20; x++) {
@@ -525,8 +577,39 @@ static int lzx_read_lens(struct LZXstate *pState, UBYTE *lens, ULONG first,
     return 0;
 }
 
-int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
-                  unsigned char *outpos, int inlen, int outlen)
+/* the decoding loop is built twice: as is, and with DETAIL counting
+ * into pState->detail, which is only used when built with XNB_LZX_STATS.
+ * the counting can't cost anything otherwise. */
+#undef HUFFSYM_LONG
+#undef HUFFSYM_DONE
+#define HUFFSYM_LONG(tbl)                                                 \
+    if constexpr (DETAIL) {                                               \
+        detail->long_codes[LZX_TREE_##tbl]++;                             \
+    }
+#define HUFFSYM_DONE(tbl)                                                 \
+    if constexpr (DETAIL) {                                               \
+        detail->symbols[LZX_TREE_##tbl]++;                                \
+    }
+
+static void count_match(struct LZXdetail *detail, ULONG slot, ULONG offset,
+                        int length)
+{
+    int bits = 0;
+
+    detail->lengths[length]++;
+    if (slot < 3) {
+        detail->repeats[slot]++;
+    } else {
+        while (offset >> bits) {
+            bits++;
+        }
+        detail->offsets[bits]++;
+    }
+}
+
+template <bool DETAIL>
+static int decompress(struct LZXstate *pState, unsigned char *inpos,
+                      unsigned char *outpos, int inlen, int outlen)
 {
     UBYTE *endinp = inpos + inlen;
     UBYTE *window = pState->window;
@@ -548,6 +631,12 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
     int togo = outlen, this_run, main_element, aligned_bits;
     int match_length, length_footer, extra, verbatim_bits;
 
+    /* counted locally and only added up at the end, to keep the loops
+     * below free of memory writes */
+    ULONG blocks[4] = {0, 0, 0, 0};
+    ULONG literals = 0, matches = 0;
+    struct LZXdetail *detail = pState->detail;
+
     INIT_BITSTREAM;
 
     /* read header if necessary */
@@ -577,6 +666,11 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
             READ_BITS(i, 16);
             READ_BITS(j, 8);
             pState->block_remaining = pState->block_length = (i << 8) | j;
+            blocks[pState->block_type & 3]++;
+            if constexpr (DETAIL) {
+                detail->block_bytes[pState->block_type & 3] +=
+                    pState->block_length;
+            }
 
             switch (pState->block_type) {
             case LZX_BLOCKTYPE_ALIGNED:
@@ -607,6 +701,9 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
                 if (bitsleft > 16) {
                     inpos -= 2; /* and align the bitstream! */
                 }
+                if (endinp - inpos < 12) {
+                    return DECR_ILLEGALDATA;
+                }
                 R0 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) |
                      (inpos[3] << 24);
                 inpos += 4;
@@ -662,10 +759,12 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
                         /* literal: 0 to LZX_NUM_CHARS-1 */
                         window[window_posn++] = main_element;
                         this_run--;
+                        literals++;
                     } else {
                         /* match: LZX_NUM_CHARS + ((slot<<3) |
                          * length_header (3 bits)) */
                         main_element -= LZX_NUM_CHARS;
+                        matches++;
 
                         match_length =
                             main_element & LZX_NUM_PRIMARY_LENGTHS;
@@ -705,6 +804,11 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
                             R0 = match_offset;
                         }
 
+                        if constexpr (DETAIL) {
+                            count_match(detail, main_element >> 3,
+                                        match_offset, match_length);
+                        }
+
                         rundest = window + window_posn;
                         runsrc = rundest - match_offset;
                         window_posn += match_length;
@@ -735,10 +839,12 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
                         /* literal: 0 to LZX_NUM_CHARS-1 */
                         window[window_posn++] = main_element;
                         this_run--;
+                        literals++;
                     } else {
                         /* match: LZX_NUM_CHARS + ((slot<<3) |
                          * length_header (3 bits)) */
                         main_element -= LZX_NUM_CHARS;
+                        matches++;
 
                         match_length =
                             main_element & LZX_NUM_PRIMARY_LENGTHS;
@@ -791,6 +897,11 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
                             R0 = match_offset;
                         }
 
+                        if constexpr (DETAIL) {
+                            count_match(detail, main_element >> 3,
+                                        match_offset, match_length);
+                        }
+
                         rundest = window + window_posn;
                         runsrc = rundest - match_offset;
                         window_posn += match_length;
@@ -840,6 +951,14 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
     pState->R1 = R1;
     pState->R2 = R2;
 
+    if (pState->counters) {
+        for (i = 1; i < 4; i++) {
+            pState->counters->blocks[i] += blocks[i];
+        }
+        pState->counters->literals += literals;
+        pState->counters->matches += matches;
+    }
+
     /* intel E8 decoding */
     if ((pState->frames_read++ < 32768) && pState->intel_filesize != 0) {
         if (outlen <= 6 || !pState->intel_started) {
@@ -876,6 +995,17 @@ int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
     return DECR_OK;
 }
 
+int LZXdecompress(struct LZXstate *pState, unsigned char *inpos,
+                  unsigned char *outpos, int inlen, int outlen)
+{
+#ifdef XNB_LZX_STATS
+    if (pState->detail) {
+        return decompress<true>(pState, inpos, outpos, inlen, outlen);
+    }
+#endif
+    return decompress<false>(pState, inpos, outpos, inlen, outlen);
+}
+
 #ifdef LZX_CHM_TESTDRIVER
 int main(int c, char **v)
 {
@@ -39,6 +39,34 @@ extern "C" {
 /* opaque state structure */
 struct LZXstate;
 
+/* running totals of what was decoded, for instrumentation */
+struct LZXcounters
+{
+    unsigned long long blocks[4]; /* indexed by block type, 1 to 3 */
+    unsigned long long literals;
+    unsigned long long matches;
+};
+
+/* the huffman trees, for indexing LZXdetail */
+#define LZX_TREE_PRETREE  (0)
+#define LZX_TREE_MAINTREE (1)
+#define LZX_TREE_LENGTH   (2)
+#define LZX_TREE_ALIGNED  (3)
+
+/* what the decoder spent its time on, in more detail than LZXcounters.
+ * only collected when built with XNB_LZX_STATS */
+struct LZXdetail
+{
+    unsigned long long block_bytes[4]; /* bytes out by block type     */
+    unsigned long long symbols[4];     /* huffman symbols by tree     */
+    unsigned long long long_codes[4];  /* of those, longer than the
+                                          direct lookup table         */
+    unsigned long long repeats[3];     /* matches reusing R0, R1, R2  */
+    unsigned long long lengths[258];   /* matches by length, 2-257    */
+    unsigned long long offsets[32];    /* other matches by offset
+                                          width in bits               */
+};
+
 /* create an lzx state object */
 struct LZXstate *LZXinit(int window);
 
@@ -48,6 +76,14 @@ void LZXteardown(struct LZXstate *pState);
 /* reset an lzx stream */
 int LZXreset(struct LZXstate *pState);
 
+/* add to counters after each frame from now on, or stop if NULL */
+void LZXsetcounters(struct LZXstate *pState,
+                    struct LZXcounters *counters);
+
+/* add to detail after each frame from now on, or stop if NULL. returns
+ * 0 if the decoder was built without XNB_LZX_STATS */
+int LZXsetdetail(struct LZXstate *pState, struct LZXdetail *detail);
+
 /* decompress an LZX compressed block */
 int LZXdecompress(struct LZXstate *pState,
                   unsigned char *inpos,
@@ -1,12 +1,322 @@
-#include "xnb.hpp"
+#include "catalog.hpp"
+#include "export.hpp"
+#include "incremental.hpp"
+#include "libxnb.hpp"
+#include "pool.hpp"
+#include "readers/schema.hpp"
+#include "server.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "util.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+struct Job
+{
+    fs::path input;
+    fs::path stem;
+};
+
+// Directories are expanded into the XNB files below them. Outputs go next
+// to their input, or mirror the input layout under the output directory.
+std::vector<Job> collect(const std::vector<fs::path> &inputs,
+                         const fs::path &output)
+{
+    std::vector<Job> jobs;
+
+    for (auto &input : inputs) {
+        if (!fs::is_directory(input)) {
+            auto stem = output.empty() ? fs::path(input).replace_extension()
+                                       : output / input.stem();
+            jobs.push_back({input, stem});
+            continue;
+        }
+
+        for (auto &entry : fs::recursive_directory_iterator(input)) {
+            if (!entry.is_regular_file() || !xnb::is_xnb(entry.path())) {
+                continue;
+            }
+
+            auto stem = output.empty()
+                            ? entry.path()
+                            : output / fs::relative(entry.path(), input);
+            jobs.push_back({entry.path(), stem.replace_extension()});
+        }
+    }
+
+    return jobs;
+}
+
+void usage(const char *name)
+{
+    std::cerr << "usage: " << name
+              << " [-o <dir>] [-j <threads>] [--glyphs] [--layers <layout>]"
+              << " [--data <format>]"
+              << " [--schema <file>]... [--stats <format>]"
+              << " [--trace <file>] [--incremental <manifest>]"
+              << " <file.xnb | dir>...\n"
+              << "       " << name << " [options] --serve <socket>\n"
+              << "       " << name << " index [-j <threads>] <catalog>"
+              << " <file.xnb | dir>...\n"
+              << "       " << name << " query [-l] <catalog> [<filter>]...\n"
+              << "  -o <dir>   write outputs under <dir>\n"
+              << "  -j <n>     use n threads (default: all cores)\n"
+              << "  --glyphs   write SpriteFont glyphs as separate images\n"
+              << "  --layers <strip | split | dds>\n"
+              << "             write volume slices and cube faces stacked in"
+              << " one image\n"
+              << "             (default), as an image each, or as a DDS\n"
+              << "  --data <json | yaml>\n"
+              << "             write data assets as JSON (default) or YAML\n"
+              << "  --schema <file>\n"
+              << "             load classes for reflected data from a schema\n"
+              << "  --stats <text | json>\n"
+              << "             report where the time went to stderr, as"
+              << " totals or\n"
+              << "             as JSON with every file\n"
+              << "  --trace <file>\n"
+              << "             write a Chrome trace of every phase of every"
+              << " file\n"
+              << "  --incremental <manifest>\n"
+              << "             skip files unchanged since the last run with"
+              << " the same\n"
+              << "             manifest and options\n"
+              << "  --serve <socket>\n"
+              << "             extract on requests to a Unix domain socket"
+              << " until\n"
+              << "             shut down, see server.hpp\n";
+}
+} // namespace
 
 int main(int argc, char **argv)
 {
-    std::string file_path(argv[1]);
-    Xnb file1(file_path);
+    if (argc > 1 && std::string_view(argv[1]) == "index") {
+        return catalog::index_command(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "query") {
+        return catalog::query_command(argc - 2, argv + 2);
+    }
+
+    ExportOptions options;
+    fs::path output;
+    std::vector<fs::path> inputs;
+    size_t threads = std::thread::hardware_concurrency();
+    std::string stats_format;
+    fs::path trace_path;
+    fs::path socket;
+    fs::path manifest_path;
+    std::vector<fs::path> schemas;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            if (!parse_threads(argv[++i], threads)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--glyphs") {
+            options.split_glyphs = true;
+        } else if (arg == "--layers" && i + 1 < argc) {
+            std::string layout(argv[++i]);
+            if (layout == "strip") {
+                options.layers = LayerLayout::Strip;
+            } else if (layout == "split") {
+                options.layers = LayerLayout::Split;
+            } else if (layout == "dds") {
+                options.layers = LayerLayout::Dds;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--data" && i + 1 < argc) {
+            std::string format(argv[++i]);
+            if (format == "json") {
+                options.data = DataFormat::Json;
+            } else if (format == "yaml") {
+                options.data = DataFormat::Yaml;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--schema" && i + 1 < argc) {
+            schemas.push_back(argv[++i]);
+            if (!readers::load_schema(schemas.back())) {
+                return 1;
+            }
+        } else if ((arg == "--stats" && i + 1 < argc) ||
+                   arg.starts_with("--stats=")) {
+            stats_format = arg == "--stats" ? argv[++i] : arg.substr(8);
+            if (stats_format != "text" && stats_format != "json") {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--incremental" && i + 1 < argc) {
+            manifest_path = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            socket = argv[++i];
+        } else if (arg.starts_with("-")) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty() == socket.empty() ||
+        !(socket.empty() || manifest_path.empty())) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Files are spread over the pool, and each file can split its own work
+    // over the same pool.
+    xnb::Context context(threads);
+    options.pool = &context.pool;
+
+    if (!socket.empty()) {
+        context.options = options;
+        return server::serve(context, socket);
+    }
+
+    auto jobs = collect(inputs, output);
+    std::atomic<int> failures = 0;
+
+    // Effects are compiled into every XNB that uses them, so a batch keeps
+    // a single copy of each.
+    if (jobs.size() > 1) {
+        options.store = &context.store;
+    }
+    context.options = options;
+
+    // Each file gets the entry it will have in the manifest, kept apart
+    // like the records below until the run is over.
+    incremental::Manifest manifest;
+    std::vector<incremental::Entry> entries;
+    std::atomic<int> skipped = 0;
+    if (!manifest_path.empty()) {
+        manifest.load(manifest_path, incremental::key(options, schemas));
+        entries.resize(jobs.size());
+    }
+
+    // Each file has a record of its own, so nothing is shared between the
+    // threads filling them in.
+    std::vector<stats::File> records(stats_format.empty() ? 0 : jobs.size());
+    if (!trace_path.empty()) {
+        trace::enable();
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    context.pool.parallel_for(jobs.size(), [&](size_t i) {
+        auto &job = jobs[i];
+        trace::FileScope scope(i);
+        trace::Span span("file");
+
+        stats::Record *record = nullptr;
+        if (!records.empty()) {
+            records[i].path = job.input.string();
+            record = &records[i].record;
+        }
+
+        if (!entries.empty()) {
+            auto done = incremental::extract(context, job.input, job.stem,
+                                             manifest.find(job.input),
+                                             entries[i], record);
+            if (!done) {
+                WARN(done.error().message);
+                ++failures;
+                entries[i] = {};
+                return;
+            }
+            if (*done) {
+                ++skipped;
+            }
+            if (record) {
+                records[i].ok = true;
+            }
+            return;
+        }
+
+        auto document = xnb::load(context, job.input, record);
+        if (!document) {
+            WARN(document.error().message);
+            ++failures;
+            return;
+        }
+
+        auto exported = xnb::export_to(context, *document, job.stem);
+        if (!exported) {
+            WARN(exported.error().message);
+            ++failures;
+        } else if (record) {
+            records[i].ok = true;
+        }
+
+        xnb::recycle(context, std::move(*document));
+    });
+
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - start;
+
+    if (!manifest_path.empty()) {
+        // Files that failed are left out, so the next run tries them again.
+        // So are files that are gone.
+        std::erase_if(manifest.entries, [](auto &entry) {
+            std::error_code error;
+            return !fs::exists(entry.first, error);
+        });
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            auto input = jobs[i].input.string();
+            if (entries[i].stem.empty()) {
+                manifest.entries.erase(input);
+            } else {
+                manifest.entries[input] = std::move(entries[i]);
+            }
+        }
+
+        INFO(skipped.load(), " of ", jobs.size(), " files were unchanged");
+        if (!manifest.save(manifest_path)) {
+            std::cerr << "Could not write " << manifest_path.string()
+                      << "\n";
+            return 1;
+        }
+    }
+
+    if (stats_format == "text") {
+        stats::write_text(stderr, records, wall.count());
+    } else if (stats_format == "json") {
+        JsonEmitter out(stderr);
+        stats::write_json(out, records, wall.count());
+        out.finish();
+    }
+
+    if (!trace_path.empty()) {
+        std::vector<std::string> names;
+        for (auto &job : jobs) {
+            names.push_back(job.input.string());
+        }
+        if (!trace::write(trace_path, names)) {
+            std::cerr << "Could not write " << trace_path.string() << "\n";
+            return 1;
+        }
+    }
 
-    return 0;
+    return failures ? 1 : 0;
 }
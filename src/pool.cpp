@@ -0,0 +1,137 @@
+#include "pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([this] { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping && jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+/*
+ * Indices are claimed from a shared counter by the caller and by up to one
+ * helper job per worker. Helpers that only get scheduled after every index
+ * is taken return straight away, so the batch state is shared with them
+ * rather than living on the caller's stack.
+ *
+ * NOTE: A task that throws on a worker would end the program, so the
+ * first exception is kept and thrown again from here once the batch is
+ * done. The indices left after it are counted off without being run.
+ */
+void ThreadPool::parallel_for(size_t count,
+                              const std::function<void(size_t)> &task)
+{
+    if (count == 0) {
+        return;
+    }
+
+    struct Batch
+    {
+        const std::function<void(size_t)> *task;
+        size_t count;
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> done = 0;
+        std::atomic<bool> failed = false;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->task = &task;
+    batch->count = count;
+
+    auto run = [batch] {
+        size_t i;
+        while ((i = batch->next++) < batch->count) {
+            try {
+                if (!batch->failed) {
+                    (*batch->task)(i);
+                }
+            } catch (...) {
+                std::lock_guard lock(batch->mutex);
+                if (!batch->error) {
+                    batch->error = std::current_exception();
+                }
+                batch->failed = true;
+            }
+            if (++batch->done == batch->count) {
+                std::lock_guard lock(batch->mutex);
+                batch->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), count - 1);
+    if (helpers > 0) {
+        {
+            std::lock_guard lock(mutex);
+            for (size_t i = 0; i < helpers; ++i) {
+                jobs.push_back(run);
+            }
+        }
+        wake.notify_all();
+    }
+
+    run();
+
+    std::unique_lock lock(batch->mutex);
+    batch->finished.wait(lock,
+                         [&] { return batch->done == batch->count; });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+bool parse_threads(std::string_view text, size_t &threads)
+{
+    size_t value;
+    auto end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    if (result.ec != std::errc() || result.ptr != end) {
+        return false;
+    }
+    threads = std::max<size_t>(value, 1);
+    return true;
+}
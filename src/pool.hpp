@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+ * A fixed set of worker threads. Work is handed out through parallel_for,
+ * where the calling thread takes part as well, so it can be called from
+ * inside a task (a file being decoded on the pool splitting its own work)
+ * without tying up threads waiting on each other.
+ */
+struct ThreadPool
+{
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // The pool runs on `threads` threads in total, the caller included.
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Runs task(i) for every i in [0, count) and returns once all are done.
+    // If a task throws, the rest may be skipped and the first exception is
+    // thrown from here.
+    void parallel_for(size_t count, const std::function<void(size_t)> &task);
+
+    void work();
+};
+
+// Reads a thread count as given on the command line, where 0 means one.
+// Returns false if the text isn't a number.
+bool parse_threads(std::string_view text, size_t &threads);
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/primitives.hpp"
+#include "readers/reader.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace readers
+{
+/*
+ * Elements that aren't one of the types known at compile time are read
+ * through a type reader. The reader is resolved once from the generic
+ * argument, but reference types still carry a type index per element so
+ * that subclasses can be stored, hence those go through the manifest.
+ */
+template <> struct Element<ReaderPtr>
+{
+    static constexpr bool blittable = false;
+    static constexpr size_t size = 1;
+
+    ReaderFactory factory;
+    bool value_type = false;
+
+    ReaderPtr read(Buffer &buffer, const Manifest &manifest) const
+    {
+        if (!value_type) {
+            return manifest.read_object(buffer);
+        }
+
+        auto reader = factory();
+        reader->read(buffer, manifest);
+        return reader;
+    }
+};
+
+inline void emit(Emitter &out, const ReaderPtr &value)
+{
+    if (value) {
+        value->emit(out);
+    } else {
+        out.null();
+    }
+}
+
+// ListReader`1 and ArrayReader`1 share a layout: a uint32 count followed
+// by the elements.
+template <typename T, ReaderType Kind> struct SequenceReader : Reader
+{
+    Element<T> element;
+    std::vector<T> values;
+
+    SequenceReader(Element<T> element = {}) : element(std::move(element)) {}
+
+    virtual ReaderType type() { return Kind; }
+
+    virtual void read(Buffer &buffer, const Manifest &manifest)
+    {
+        values.clear();
+        if (buffer.remaining() < 4) {
+            DEBUG("Sequence overruns buffer");
+            return;
+        }
+        size_t count = buffer.read_u32();
+
+        if constexpr (Element<T>::blittable) {
+            if (count > buffer.remaining() / sizeof(T)) {
+                DEBUG("Sequence of ", count, " elements overruns buffer");
+                return;
+            }
+            values.resize(count);
+            std::memcpy(values.data(), buffer.read(count * sizeof(T)).data(),
+                        count * sizeof(T));
+        } else {
+            // Every element takes at least a byte, which keeps a corrupt
+            // count from reserving gigabytes.
+            values.reserve(std::min(count, buffer.remaining()));
+            for (size_t i = 0; i < count; ++i) {
+                if (buffer.remaining() < Element<T>::size) {
+                    break;
+                }
+                values.push_back(element.read(buffer, manifest));
+            }
+
+            if (values.size() < count) {
+                DEBUG("Sequence of ", count, " elements overruns buffer");
+                values.clear();
+            }
+        }
+    }
+
+    virtual void emit(Emitter &out)
+    {
+        out.begin_array();
+        for (const auto &value : values) {
+            readers::emit(out, value);
+        }
+        out.end_array();
+    }
+};
+
+template <typename T> using ListReader = SequenceReader<T, List>;
+template <typename T> using ArrayReader = SequenceReader<T, Array>;
+
+template <typename K, typename V> struct DictionaryReader : Reader
+{
+    struct Entry
+    {
+        K key;
+        V value;
+    };
+
+    // Keys and values are interleaved, so the entries can only be copied
+    // in one go when both are blittable and pack without padding.
+    static constexpr bool blittable = Element<K>::blittable &&
+                                      Element<V>::blittable &&
+                                      sizeof(Entry) == sizeof(K) + sizeof(V);
+
+    Element<K> key_element;
+    Element<V> value_element;
+    std::vector<Entry> entries;
+
+    DictionaryReader(Element<K> key_element = {},
+                     Element<V> value_element = {})
+        : key_element(std::move(key_element)),
+          value_element(std::move(value_element))
+    {
+    }
+
+    virtual ReaderType type() { return Dictionary; }
+
+    virtual void read(Buffer &buffer, const Manifest &manifest)
+    {
+        entries.clear();
+        if (buffer.remaining() < 4) {
+            DEBUG("Dictionary overruns buffer");
+            return;
+        }
+        size_t count = buffer.read_u32();
+
+        if constexpr (blittable) {
+            if (count > buffer.remaining() / sizeof(Entry)) {
+                DEBUG("Dictionary of ", count, " entries overruns buffer");
+                return;
+            }
+            entries.resize(count);
+            std::memcpy(entries.data(),
+                        buffer.read(count * sizeof(Entry)).data(),
+                        count * sizeof(Entry));
+        } else {
+            entries.reserve(std::min(count, buffer.remaining()));
+            for (size_t i = 0; i < count; ++i) {
+                if (buffer.remaining() < Element<K>::size) {
+                    break;
+                }
+                K key = key_element.read(buffer, manifest);
+                if (buffer.remaining() < Element<V>::size) {
+                    break;
+                }
+                V value = value_element.read(buffer, manifest);
+                entries.push_back({std::move(key), std::move(value)});
+            }
+
+            if (entries.size() < count) {
+                DEBUG("Dictionary of ", count, " entries overruns buffer");
+                entries.clear();
+            }
+        }
+    }
+
+    /*
+     * Dictionaries keyed by strings or numbers become objects, as in the
+     * game's own data files. Any other key can't be an object key, so
+     * those dictionaries become arrays of key and value pairs instead.
+     */
+    virtual void emit(Emitter &out)
+    {
+        if constexpr (std::is_same_v<K, std::string_view> ||
+                      std::is_integral_v<K>) {
+            out.begin_object();
+            for (auto &entry : entries) {
+                if constexpr (std::is_same_v<K, std::string_view>) {
+                    out.key(entry.key);
+                } else {
+                    char text[24];
+                    auto [end, error] =
+                        std::to_chars(text, text + sizeof(text), entry.key);
+                    out.key(std::string_view(text, end - text));
+                }
+                readers::emit(out, entry.value);
+            }
+            out.end_object();
+        } else {
+            out.begin_array();
+            for (auto &entry : entries) {
+                out.begin_object();
+                out.key("Key");
+                readers::emit(out, entry.key);
+                out.key("Value");
+                readers::emit(out, entry.value);
+                out.end_object();
+            }
+            out.end_array();
+        }
+    }
+};
+} // namespace readers
@@ -0,0 +1,54 @@
+#include "readers/effect.hpp"
+
+#include "util.hpp"
+
+namespace readers
+{
+BasicEffectReader::BasicEffectReader()
+    : texture{}, diffuse_color{}, emissive_color{}, specular_color{},
+      specular_power(0), alpha(0), vertex_color_enabled(false)
+{
+}
+
+ReaderType BasicEffectReader::type() { return BasicEffect; }
+
+void BasicEffectReader::read(Buffer &buffer, const Manifest &manifest)
+{
+    // An external reference: just the asset name, without a type index.
+    texture = buffer.read_string();
+
+    // Three colors, the specular power, the alpha and a flag.
+    if (buffer.remaining() < 3 * sizeof(Vector3) + 2 * sizeof(float) + 1) {
+        DEBUG("Basic effect overruns buffer");
+        return;
+    }
+    diffuse_color = Element<Vector3>{}.read(buffer, manifest);
+    emissive_color = Element<Vector3>{}.read(buffer, manifest);
+    specular_color = Element<Vector3>{}.read(buffer, manifest);
+    specular_power = Element<float>{}.read(buffer, manifest);
+    alpha = Element<float>{}.read(buffer, manifest);
+    vertex_color_enabled = Element<bool>{}.read(buffer, manifest);
+
+    DEBUG("Texture: ", texture);
+}
+
+EffectReader::EffectReader() : bytecode{} {}
+
+ReaderType EffectReader::type() { return Effect; }
+
+void EffectReader::read(Buffer &buffer, const Manifest &)
+{
+    if (buffer.remaining() < 4) {
+        DEBUG("Effect size overruns buffer");
+        return;
+    }
+    size_t size = buffer.read_u32();
+    if (size > buffer.remaining()) {
+        DEBUG("Effect of ", size, " bytes overruns buffer");
+        return;
+    }
+    bytecode = buffer.read(size);
+
+    DEBUG("Bytecode size: ", size);
+}
+} // namespace readers
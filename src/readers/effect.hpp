@@ -0,0 +1,46 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/primitives.hpp"
+#include "readers/reader.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace readers
+{
+struct BasicEffectReader : Reader
+{
+    // Asset name of the texture, relative to this XNB without extension.
+    // Empty if the effect is untextured.
+    std::string texture;
+
+    Vector3 diffuse_color;
+    Vector3 emissive_color;
+    Vector3 specular_color;
+    float specular_power;
+    float alpha;
+    bool vertex_color_enabled;
+
+    BasicEffectReader();
+    ~BasicEffectReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+// A compiled effect. The bytecode is opaque to us and only passed through.
+struct EffectReader : Reader
+{
+    // Viewed in place in the decompressed buffer.
+    std::span<const uint8_t> bytecode;
+
+    EffectReader();
+    ~EffectReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+} // namespace readers
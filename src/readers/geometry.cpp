@@ -0,0 +1,174 @@
+#include "readers/geometry.hpp"
+
+#include "util.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace readers
+{
+size_t element_size(VertexElementFormat format)
+{
+    switch (format) {
+    case VertexElementFormat::Single:
+    case VertexElementFormat::Color:
+    case VertexElementFormat::Byte4:
+    case VertexElementFormat::Short2:
+    case VertexElementFormat::NormalizedShort2:
+    case VertexElementFormat::HalfVector2:
+        return 4;
+    case VertexElementFormat::Vector2:
+    case VertexElementFormat::Short4:
+    case VertexElementFormat::NormalizedShort4:
+    case VertexElementFormat::HalfVector4:
+        return 8;
+    case VertexElementFormat::Vector3:
+        return 12;
+    case VertexElementFormat::Vector4:
+        return 16;
+    }
+    return 0;
+}
+
+VertexDeclarationReader::VertexDeclarationReader() : stride(0), elements{}
+{
+}
+
+ReaderType VertexDeclarationReader::type() { return VertexDeclaration; }
+
+const VertexElement *
+VertexDeclarationReader::find(VertexElementUsage usage,
+                              uint32_t usage_index) const
+{
+    for (auto &element : elements) {
+        if (element.usage == usage && element.usage_index == usage_index) {
+            return &element;
+        }
+    }
+    return nullptr;
+}
+
+void VertexDeclarationReader::read(Buffer &buffer, const Manifest &)
+{
+    // The stride and the element count, then 16 bytes per element.
+    elements.clear();
+    if (buffer.remaining() < 8) {
+        DEBUG("Vertex declaration overruns buffer");
+        return;
+    }
+    uint32_t declared_stride = buffer.read_u32();
+    size_t count = buffer.read_u32();
+    if (count > buffer.remaining() / 16) {
+        DEBUG("Vertex declaration of ", count, " elements overruns buffer");
+        return;
+    }
+    stride = declared_stride;
+
+    for (size_t i = 0; i < count; ++i) {
+        VertexElement element;
+        element.offset = buffer.read_u32();
+        element.format = VertexElementFormat(buffer.read_i32());
+        element.usage = VertexElementUsage(buffer.read_i32());
+        element.usage_index = buffer.read_u32();
+        elements.push_back(element);
+    }
+
+    DEBUG("Vertex stride: ", stride);
+    DEBUG("Vertex elements: ", elements.size());
+}
+
+VertexBufferReader::VertexBufferReader() : vertex_count(0), data{} {}
+
+ReaderType VertexBufferReader::type() { return VertexBuffer; }
+
+void VertexBufferReader::read(Buffer &buffer, const Manifest &manifest)
+{
+    // The declaration is stored inline, without a type index.
+    declaration.read(buffer, manifest);
+    if (buffer.remaining() < 4) {
+        DEBUG("Vertex count overruns buffer");
+        return;
+    }
+    vertex_count = buffer.read_u32();
+
+    size_t size = size_t(vertex_count) * declaration.stride;
+    if (size > buffer.remaining()) {
+        DEBUG("Vertex data overruns buffer");
+        vertex_count = 0;
+        return;
+    }
+    data = buffer.read(size);
+
+    DEBUG("Vertex count: ", vertex_count);
+}
+
+IndexBufferReader::IndexBufferReader() : sixteen_bits(false), data{} {}
+
+ReaderType IndexBufferReader::type() { return IndexBuffer; }
+
+void IndexBufferReader::read(Buffer &buffer, const Manifest &)
+{
+    // Whether indices take 16 or 32 bits, then the size of the data.
+    if (buffer.remaining() < 5) {
+        DEBUG("Index buffer overruns buffer");
+        return;
+    }
+    sixteen_bits = buffer.read_byte() != 0;
+    size_t size = buffer.read_u32();
+
+    if (size > buffer.remaining()) {
+        DEBUG("Index data overruns buffer");
+        return;
+    }
+    data = buffer.read(size);
+
+    DEBUG("Index count: ", count());
+}
+
+std::vector<uint32_t> IndexBufferReader::widen() const
+{
+    std::vector<uint32_t> indices(count());
+
+    if (!sixteen_bits) {
+        std::memcpy(indices.data(), data.data(), indices.size() * 4);
+        return indices;
+    }
+
+    const uint8_t *in = data.data();
+    uint32_t *out = indices.data();
+    size_t i = 0;
+
+    // Eight indices at a time, zero extended into two vectors of four.
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= indices.size(); i += 8) {
+        __m128i narrow =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                         _mm_unpacklo_epi16(narrow, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4),
+                         _mm_unpackhi_epi16(narrow, zero));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= indices.size(); i += 8) {
+        uint16x8_t narrow =
+            vreinterpretq_u16_u8(vld1q_u8(in + i * 2));
+        vst1q_u32(out + i, vmovl_u16(vget_low_u16(narrow)));
+        vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(narrow)));
+    }
+#endif
+
+    for (; i < indices.size(); ++i) {
+        out[i] = in[i * 2] | (in[i * 2 + 1] << 8);
+    }
+
+    return indices;
+}
+} // namespace readers
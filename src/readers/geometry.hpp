@@ -0,0 +1,141 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/reader.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace readers
+{
+enum class VertexElementFormat
+{
+    Single,
+    Vector2,
+    Vector3,
+    Vector4,
+    Color,
+    Byte4,
+    Short2,
+    Short4,
+    NormalizedShort2,
+    NormalizedShort4,
+    HalfVector2,
+    HalfVector4
+};
+
+enum class VertexElementUsage
+{
+    Position,
+    Color,
+    TextureCoordinate,
+    Normal,
+    Binormal,
+    Tangent,
+    BlendIndices,
+    BlendWeight,
+    Depth,
+    Fog,
+    PointSize,
+    Sample,
+    TessellateFactor
+};
+
+// Size in bytes of an element format, 0 if unknown.
+size_t element_size(VertexElementFormat format);
+
+struct VertexElement
+{
+    uint32_t offset;
+    VertexElementFormat format;
+    VertexElementUsage usage;
+    uint32_t usage_index;
+};
+
+// Every vertex-th element of a vertex buffer, read in place. Elements are
+// copied out on access since the buffer makes no alignment promises.
+template <typename T> struct StridedView
+{
+    const uint8_t *base = nullptr;
+    size_t stride = 0;
+    size_t count = 0;
+
+    T operator[](size_t i) const
+    {
+        T value;
+        std::memcpy(&value, base + i * stride, sizeof(T));
+        return value;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+struct VertexDeclarationReader : Reader
+{
+    uint32_t stride;
+    std::vector<VertexElement> elements;
+
+    VertexDeclarationReader();
+    ~VertexDeclarationReader(){};
+
+    const VertexElement *find(VertexElementUsage usage,
+                              uint32_t usage_index = 0) const;
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+struct VertexBufferReader : Reader
+{
+    VertexDeclarationReader declaration;
+    uint32_t vertex_count;
+
+    // Interleaved vertices, viewed in place in the decompressed buffer.
+    std::span<const uint8_t> data;
+
+    VertexBufferReader();
+    ~VertexBufferReader(){};
+
+    // A view of one attribute across all vertices. Empty if the buffer has
+    // no such attribute, or if its format isn't the size of T.
+    template <typename T>
+    StridedView<T> attribute(VertexElementUsage usage,
+                             uint32_t usage_index = 0) const
+    {
+        auto element = declaration.find(usage, usage_index);
+        if (!element || element_size(element->format) != sizeof(T) ||
+            element->offset + sizeof(T) > declaration.stride) {
+            return {};
+        }
+        return {data.data() + element->offset, declaration.stride,
+                vertex_count};
+    }
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+struct IndexBufferReader : Reader
+{
+    bool sixteen_bits;
+
+    // Indices, viewed in place in the decompressed buffer.
+    std::span<const uint8_t> data;
+
+    IndexBufferReader();
+    ~IndexBufferReader(){};
+
+    size_t count() const { return data.size() / (sixteen_bits ? 2 : 4); }
+
+    // The indices as 32 bit values. 16 bit indices are only widened when
+    // this is called, for consumers that can't take them as they are.
+    std::vector<uint32_t> widen() const;
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+} // namespace readers
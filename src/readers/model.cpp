@@ -0,0 +1,79 @@
+#include "readers/model.hpp"
+
+#include "util.hpp"
+
+namespace readers
+{
+ModelReader::ModelReader() : bones{}, meshes{}, root_bone(-1), tag{} {}
+
+ReaderType ModelReader::type() { return Model; }
+
+// Bone references are 1-based with 0 for none, and take a single byte
+// unless the model has too many bones for it.
+int ModelReader::read_bone_reference(Buffer &buffer)
+{
+    size_t index = bones.size() < 255 ? buffer.read_byte() : buffer.read_u32();
+    if (index == 0 || index > bones.size()) {
+        return -1;
+    }
+    return int(index - 1);
+}
+
+void ModelReader::read(Buffer &buffer, const Manifest &manifest)
+{
+    size_t bone_count = buffer.read_u32();
+
+    bones.clear();
+    for (size_t i = 0; i < bone_count && buffer.remaining() > 0; ++i) {
+        Bone bone;
+        bone.name = Element<std::string_view>{}.read(buffer, manifest);
+        bone.transform = Element<Matrix>{}.read(buffer, manifest);
+        bones.push_back(std::move(bone));
+    }
+
+    // The hierarchy comes after all the bones, so that references can
+    // point forward.
+    for (auto &bone : bones) {
+        bone.parent = read_bone_reference(buffer);
+
+        size_t child_count = buffer.read_u32();
+        for (size_t i = 0; i < child_count && buffer.remaining() > 0; ++i) {
+            bone.children.push_back(read_bone_reference(buffer));
+        }
+    }
+
+    size_t mesh_count = buffer.read_u32();
+
+    meshes.clear();
+    for (size_t i = 0; i < mesh_count && buffer.remaining() > 0; ++i) {
+        Mesh mesh;
+        mesh.name = Element<std::string_view>{}.read(buffer, manifest);
+        mesh.parent_bone = read_bone_reference(buffer);
+        mesh.center = Element<Vector3>{}.read(buffer, manifest);
+        mesh.radius = Element<float>{}.read(buffer, manifest);
+        mesh.tag = manifest.read_object(buffer);
+
+        size_t part_count = buffer.read_u32();
+        for (size_t j = 0; j < part_count && buffer.remaining() > 0; ++j) {
+            MeshPart part;
+            part.vertex_offset = buffer.read_i32();
+            part.vertex_count = buffer.read_i32();
+            part.start_index = buffer.read_i32();
+            part.primitive_count = buffer.read_i32();
+            part.tag = manifest.read_object(buffer);
+            part.vertex_buffer = manifest.read_shared_resource(buffer);
+            part.index_buffer = manifest.read_shared_resource(buffer);
+            part.effect = manifest.read_shared_resource(buffer);
+            mesh.parts.push_back(std::move(part));
+        }
+
+        meshes.push_back(std::move(mesh));
+    }
+
+    root_bone = read_bone_reference(buffer);
+    tag = manifest.read_object(buffer);
+
+    DEBUG("Bones: ", bones.size());
+    DEBUG("Meshes: ", meshes.size());
+}
+} // namespace readers
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/primitives.hpp"
+#include "readers/reader.hpp"
+
+#include <string>
+#include <vector>
+
+namespace readers
+{
+struct Bone
+{
+    std::string name;
+    Matrix transform;
+
+    // Indices into the model's bones, -1 for none.
+    int parent = -1;
+    std::vector<int> children;
+};
+
+// A range of one vertex and index buffer drawn with one effect. The
+// buffers and effect are shared resources, usually shared between parts.
+struct MeshPart
+{
+    int vertex_offset = 0;
+    int vertex_count = 0;
+    int start_index = 0;
+    int primitive_count = 0;
+    ReaderPtr tag;
+
+    SharedResource vertex_buffer;
+    SharedResource index_buffer;
+    SharedResource effect;
+};
+
+struct Mesh
+{
+    std::string name;
+    int parent_bone = -1;
+    Vector3 center{};
+    float radius = 0;
+    ReaderPtr tag;
+    std::vector<MeshPart> parts;
+};
+
+struct ModelReader : Reader
+{
+    std::vector<Bone> bones;
+    std::vector<Mesh> meshes;
+    int root_bone;
+    ReaderPtr tag;
+
+    ModelReader();
+    ~ModelReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+
+    int read_bone_reference(Buffer &buffer);
+};
+
+} // namespace readers
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "emitter.hpp"
+#include "readers/reader.hpp"
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace readers
+{
+// NOTE: XNB content is little endian and the XNA math types are plain
+// structs of floats and ints, so on a little endian host they can be
+// copied straight out of the buffer.
+static_assert(std::endian::native == std::endian::little);
+
+struct Vector2
+{
+    float x, y;
+};
+
+struct Vector3
+{
+    float x, y, z;
+};
+
+struct Vector4
+{
+    float x, y, z, w;
+};
+
+struct Quaternion
+{
+    float x, y, z, w;
+};
+
+struct Matrix
+{
+    float m[16];
+};
+
+struct Point
+{
+    int32_t x, y;
+};
+
+struct Rectangle
+{
+    int32_t x, y, width, height;
+};
+
+struct Color
+{
+    uint8_t r, g, b, a;
+};
+
+// Names of the type reader and of the target type it produces, as they
+// appear in the XNB header and in generic arguments respectively.
+template <typename T> struct TypeInfo;
+
+#define XNB_TYPE_INFO(T, READER, TARGET)                                  \
+    template <> struct TypeInfo<T>                                        \
+    {                                                                     \
+        static constexpr std::string_view reader =                        \
+            "Microsoft.Xna.Framework.Content." READER;                    \
+        static constexpr std::string_view target = TARGET;                \
+    }
+
+XNB_TYPE_INFO(bool, "BooleanReader", "System.Boolean");
+XNB_TYPE_INFO(uint8_t, "ByteReader", "System.Byte");
+XNB_TYPE_INFO(int8_t, "SByteReader", "System.SByte");
+XNB_TYPE_INFO(int16_t, "Int16Reader", "System.Int16");
+XNB_TYPE_INFO(uint16_t, "UInt16Reader", "System.UInt16");
+XNB_TYPE_INFO(int32_t, "Int32Reader", "System.Int32");
+XNB_TYPE_INFO(uint32_t, "UInt32Reader", "System.UInt32");
+XNB_TYPE_INFO(int64_t, "Int64Reader", "System.Int64");
+XNB_TYPE_INFO(uint64_t, "UInt64Reader", "System.UInt64");
+XNB_TYPE_INFO(float, "SingleReader", "System.Single");
+XNB_TYPE_INFO(double, "DoubleReader", "System.Double");
+XNB_TYPE_INFO(char32_t, "CharReader", "System.Char");
+XNB_TYPE_INFO(std::string_view, "StringReader", "System.String");
+XNB_TYPE_INFO(Vector2, "Vector2Reader", "Microsoft.Xna.Framework.Vector2");
+XNB_TYPE_INFO(Vector3, "Vector3Reader", "Microsoft.Xna.Framework.Vector3");
+XNB_TYPE_INFO(Vector4, "Vector4Reader", "Microsoft.Xna.Framework.Vector4");
+XNB_TYPE_INFO(Quaternion, "QuaternionReader",
+              "Microsoft.Xna.Framework.Quaternion");
+XNB_TYPE_INFO(Matrix, "MatrixReader", "Microsoft.Xna.Framework.Matrix");
+XNB_TYPE_INFO(Point, "PointReader", "Microsoft.Xna.Framework.Point");
+XNB_TYPE_INFO(Rectangle, "RectangleReader",
+              "Microsoft.Xna.Framework.Rectangle");
+XNB_TYPE_INFO(Color, "ColorReader", "Microsoft.Xna.Framework.Color");
+
+#undef XNB_TYPE_INFO
+
+/*
+ * Element<T> knows how to read a single T as it is stored inside another
+ * object. Blittable elements have the same layout in the file as in
+ * memory, which lets collections consume a whole run of them with one
+ * copy instead of reading them one at a time.
+ *
+ * NOTE: An element past the end of the buffer reads as zero, with the
+ * cursor moved to the end, so nothing after it gets read as garbage.
+ */
+template <typename T> struct Element
+{
+    static constexpr bool blittable = std::is_trivially_copyable_v<T>;
+
+    // The fewest bytes one takes in the file, which collections check for
+    // before reading each element.
+    static constexpr size_t size = sizeof(T);
+
+    T read(Buffer &buffer, const Manifest &) const
+    {
+        T value{};
+        if (buffer.remaining() < sizeof(T)) {
+            buffer.seek(buffer.remaining());
+            return value;
+        }
+        std::memcpy(&value, buffer.read(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+};
+
+// Not every byte is a valid bool, so these are read one at a time.
+template <> struct Element<bool>
+{
+    static constexpr bool blittable = false;
+    static constexpr size_t size = 1;
+
+    bool read(Buffer &buffer, const Manifest &) const
+    {
+        return buffer.remaining() && buffer.read_byte() != 0;
+    }
+};
+
+// System.Char is written as a single UTF-8 encoded character.
+template <> struct Element<char32_t>
+{
+    static constexpr bool blittable = false;
+    static constexpr size_t size = 1;
+
+    char32_t read(Buffer &buffer, const Manifest &) const
+    {
+        if (!buffer.remaining()) {
+            return 0;
+        }
+        uint8_t lead = buffer.read_byte();
+        int trailing = lead < 0x80 ? 0 : lead < 0xE0 ? 1 : lead < 0xF0 ? 2 : 3;
+
+        char32_t value = trailing ? lead & (0x3F >> trailing) : lead;
+        while (trailing-- && buffer.remaining()) {
+            value = (value << 6) | (buffer.read_byte() & 0x3F);
+        }
+        return value;
+    }
+};
+
+// Strings are reference types, so a type index comes first. An index of 0
+// means the string is null, which is read back as an empty one.
+//
+// NOTE: Strings are viewed in the decompressed buffer rather than copied,
+// so they only live as long as the file they were read from. Anything
+// that has to outlive it can go through a StringInterner.
+template <> struct Element<std::string_view>
+{
+    static constexpr bool blittable = false;
+    static constexpr size_t size = 1;
+
+    std::string_view read(Buffer &buffer, const Manifest &) const
+    {
+        if (buffer.read_7_bit_int() == 0) {
+            return {};
+        }
+        return buffer.read_string_view();
+    }
+};
+
+// Writes single values out as data, with the XNA structs as objects.
+inline void emit(Emitter &out, bool value) { out.boolean(value); }
+
+template <std::integral T> void emit(Emitter &out, T value)
+{
+    if constexpr (std::is_signed_v<T>) {
+        out.integer(int64_t(value));
+    } else {
+        out.integer(uint64_t(value));
+    }
+}
+
+inline void emit(Emitter &out, float value) { out.real(value); }
+inline void emit(Emitter &out, double value) { out.real(value); }
+
+inline void emit(Emitter &out, char32_t value)
+{
+    char text[4];
+    size_t size = 0;
+
+    if (value < 0x80) {
+        text[size++] = char(value);
+    } else if (value < 0x800) {
+        text[size++] = char(0xC0 | (value >> 6));
+        text[size++] = char(0x80 | (value & 0x3F));
+    } else if (value < 0x10000) {
+        text[size++] = char(0xE0 | (value >> 12));
+        text[size++] = char(0x80 | ((value >> 6) & 0x3F));
+        text[size++] = char(0x80 | (value & 0x3F));
+    } else {
+        text[size++] = char(0xF0 | ((value >> 18) & 0x07));
+        text[size++] = char(0x80 | ((value >> 12) & 0x3F));
+        text[size++] = char(0x80 | ((value >> 6) & 0x3F));
+        text[size++] = char(0x80 | (value & 0x3F));
+    }
+    out.string(std::string_view(text, size));
+}
+
+inline void emit(Emitter &out, std::string_view value) { out.string(value); }
+
+using Fields = std::initializer_list<std::pair<const char *, float>>;
+
+inline void emit_fields(Emitter &out, Fields fields)
+{
+    out.begin_object();
+    for (auto [name, value] : fields) {
+        out.key(name);
+        out.real(value);
+    }
+    out.end_object();
+}
+
+inline void emit(Emitter &out, const Vector2 &v)
+{
+    emit_fields(out, {{"X", v.x}, {"Y", v.y}});
+}
+
+inline void emit(Emitter &out, const Vector3 &v)
+{
+    emit_fields(out, {{"X", v.x}, {"Y", v.y}, {"Z", v.z}});
+}
+
+inline void emit(Emitter &out, const Vector4 &v)
+{
+    emit_fields(out, {{"X", v.x}, {"Y", v.y}, {"Z", v.z}, {"W", v.w}});
+}
+
+inline void emit(Emitter &out, const Quaternion &q)
+{
+    emit_fields(out, {{"X", q.x}, {"Y", q.y}, {"Z", q.z}, {"W", q.w}});
+}
+
+inline void emit(Emitter &out, const Matrix &value)
+{
+    out.begin_array();
+    for (float m : value.m) {
+        out.real(m);
+    }
+    out.end_array();
+}
+
+inline void emit(Emitter &out, const Point &value)
+{
+    out.begin_object();
+    out.key("X");
+    out.integer(int64_t(value.x));
+    out.key("Y");
+    out.integer(int64_t(value.y));
+    out.end_object();
+}
+
+inline void emit(Emitter &out, const Rectangle &value)
+{
+    out.begin_object();
+    out.key("X");
+    out.integer(int64_t(value.x));
+    out.key("Y");
+    out.integer(int64_t(value.y));
+    out.key("Width");
+    out.integer(int64_t(value.width));
+    out.key("Height");
+    out.integer(int64_t(value.height));
+    out.end_object();
+}
+
+inline void emit(Emitter &out, const Color &value)
+{
+    out.begin_object();
+    for (auto [name, channel] : {std::pair{"R", value.r}, {"G", value.g},
+                                 {"B", value.b}, {"A", value.a}}) {
+        out.key(name);
+        out.integer(uint64_t(channel));
+    }
+    out.end_object();
+}
+
+template <typename T> struct PrimitiveReader : Reader
+{
+    T value{};
+
+    virtual ReaderType type() { return Primitive; }
+    virtual bool value_type() { return true; }
+
+    virtual void read(Buffer &buffer, const Manifest &manifest)
+    {
+        value = Element<T>{}.read(buffer, manifest);
+    }
+
+    virtual void emit(Emitter &out) { readers::emit(out, value); }
+};
+
+struct StringReader : Reader
+{
+    std::string_view value;
+
+    virtual ReaderType type() { return String; }
+
+    virtual void read(Buffer &buffer, const Manifest &)
+    {
+        value = buffer.read_string_view();
+    }
+
+    virtual void emit(Emitter &out) { out.string(value); }
+};
+} // namespace readers
@@ -0,0 +1,47 @@
+#include "readers/reader.hpp"
+
+#include "util.hpp"
+
+#include <iterator>
+
+namespace readers
+{
+const char *type_name(ReaderType type)
+{
+    static const char *NAMES[] = {
+        "Texture2D",     "Texture3D",         "TextureCube",
+        "Primitive",     "String",            "List",
+        "Array",         "Dictionary",        "SpriteFont",
+        "SoundEffect",   "VertexDeclaration", "VertexBuffer",
+        "IndexBuffer",   "Model",             "BasicEffect",
+        "Effect",        "Reflective"};
+
+    size_t index = size_t(type);
+    return index < std::size(NAMES) ? NAMES[index] : "Unknown";
+}
+
+// NOTE: Objects are prefixed with a 7 bit int indexing into the reader
+// list. Index 0 is a null reference, so the list itself is 1-based.
+ReaderPtr Manifest::read_object(Buffer &buffer) const
+{
+    size_t index = buffer.read_7_bit_int();
+
+    if (index == 0) {
+        return nullptr;
+    }
+
+    if (index > readers.size() || !readers[index - 1]) {
+        DEBUG("No reader for type index ", index);
+        return nullptr;
+    }
+
+    auto reader = readers[index - 1]();
+    reader->read(buffer, *this);
+    return reader;
+}
+
+SharedResource Manifest::read_shared_resource(Buffer &buffer) const
+{
+    return {shared_resources.get(), size_t(buffer.read_7_bit_int())};
+}
+} // namespace readers
@@ -1,19 +1,107 @@
 #pragma once
 
 #include <buffer.hpp>
+#include <emitter.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace readers
 {
 enum ReaderType
 {
-    Texture2D
+    Texture2D,
+    Texture3D,
+    TextureCube,
+    Primitive,
+    String,
+    List,
+    Array,
+    Dictionary,
+    SpriteFont,
+    SoundEffect,
+    VertexDeclaration,
+    VertexBuffer,
+    IndexBuffer,
+    Model,
+    BasicEffect,
+    Effect,
+    Reflective
 };
 
+// The name of the type, as in the enum, for reports.
+const char *type_name(ReaderType type);
+
+struct Reader;
+struct Manifest;
+
+using ReaderPtr = std::unique_ptr<Reader>;
+using ReaderFactory = std::function<ReaderPtr()>;
+
 struct Reader
 {
     Reader(){};
     virtual ~Reader(){};
     virtual ReaderType type() = 0;
-    virtual void read(Buffer buffer) = 0;
+    virtual void read(Buffer &buffer, const Manifest &manifest) = 0;
+
+    // Value types (numbers, vectors, rectangles...) are stored inline by
+    // their parent, without the type index that precedes reference types.
+    virtual bool value_type() { return false; }
+
+    // Writes the content out as data. Only readers of plain data (numbers,
+    // strings, collections, reflected classes) have anything to write.
+    virtual void emit(Emitter &out) { out.null(); }
+};
+
+/*
+ * A reference to one of the shared resources stored after the primary
+ * asset. Those are only read once the primary asset is done, so the
+ * reference keeps an index and is resolved whenever it is used.
+ */
+struct SharedResource
+{
+    const std::vector<ReaderPtr> *table = nullptr;
+
+    // 1-based, 0 is a null reference.
+    size_t index = 0;
+
+    Reader *get() const
+    {
+        if (!table || index == 0 || index > table->size()) {
+            return nullptr;
+        }
+        return (*table)[index - 1].get();
+    }
+
+    template <typename T> T *as() const { return dynamic_cast<T *>(get()); }
+};
+
+// The type readers listed in the XNB header, resolved once up front. The
+// content data refers to them by index whenever it stores a polymorphic
+// object.
+struct Manifest
+{
+    std::vector<ReaderFactory> readers;
+
+    // Kept on the heap so references stay valid if the manifest is moved.
+    std::unique_ptr<std::vector<ReaderPtr>> shared_resources =
+        std::make_unique<std::vector<ReaderPtr>>();
+
+    ReaderPtr read_object(Buffer &buffer) const;
+    SharedResource read_shared_resource(Buffer &buffer) const;
+
+    // Reads an object that is expected to come from reader T, giving null
+    // if it is anything else.
+    template <typename T> std::unique_ptr<T> read_object(Buffer &buffer) const
+    {
+        auto object = read_object(buffer);
+        if (auto typed = dynamic_cast<T *>(object.get())) {
+            object.release();
+            return std::unique_ptr<T>(typed);
+        }
+        return nullptr;
+    }
 };
 } // namespace readers
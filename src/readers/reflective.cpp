@@ -0,0 +1,407 @@
+#include "readers/reflective.hpp"
+
+#include "readers/primitives.hpp"
+#include "readers/registry.hpp"
+#include "readers/type_name.hpp"
+#include "util.hpp"
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+namespace readers
+{
+namespace
+{
+struct Primitive
+{
+    std::string_view target;
+    FieldKind kind;
+    uint32_t size;
+};
+
+template <typename T> constexpr Primitive primitive(FieldKind kind)
+{
+    return {TypeInfo<T>::target, kind, sizeof(T)};
+}
+
+const Primitive PRIMITIVES[] = {
+    primitive<bool>(FieldKind::Bool),
+    primitive<int8_t>(FieldKind::Int8),
+    primitive<uint8_t>(FieldKind::UInt8),
+    primitive<int16_t>(FieldKind::Int16),
+    primitive<uint16_t>(FieldKind::UInt16),
+    primitive<int32_t>(FieldKind::Int32),
+    primitive<uint32_t>(FieldKind::UInt32),
+    primitive<int64_t>(FieldKind::Int64),
+    primitive<uint64_t>(FieldKind::UInt64),
+    primitive<float>(FieldKind::Single),
+    primitive<double>(FieldKind::Double),
+    primitive<char32_t>(FieldKind::Char),
+    primitive<Vector2>(FieldKind::Vector2),
+    primitive<Vector3>(FieldKind::Vector3),
+    primitive<Vector4>(FieldKind::Vector4),
+    primitive<Quaternion>(FieldKind::Quaternion),
+    primitive<Matrix>(FieldKind::Matrix),
+    primitive<Point>(FieldKind::Point),
+    primitive<Rectangle>(FieldKind::Rectangle),
+    primitive<Color>(FieldKind::Color),
+};
+
+// Nested structs deeper than this can only be a struct containing itself.
+const int MAX_DEPTH = 64;
+
+// NOTE: Schemas can be loaded while files are decoded, so a class that is
+// registered again replaces the pointer and whoever still holds the old
+// one keeps it alive.
+std::shared_mutex classes_mutex;
+std::map<std::string, std::shared_ptr<const ClassInfo>, std::less<>> classes;
+
+// NOTE: Classes can refer to themselves, through a list of children for
+// instance, so a plan is cached before it is compiled and is only
+// complete once the outermost resolve returns. The lock is held for the
+// whole resolve, which may re-enter it for the classes of fields.
+std::recursive_mutex plans_mutex;
+std::map<std::string, std::shared_ptr<ClassPlan>, std::less<>> plans;
+
+// The plans added since the outermost resolve started. Those compiled for
+// fields may refer back to the classes still being compiled, so when one
+// of those fails, every plan added since it goes with it.
+std::vector<std::string> compiling;
+
+std::shared_ptr<const ClassInfo> find_class(std::string_view name)
+{
+    std::shared_lock lock(classes_mutex);
+    auto it = classes.find(name);
+    return it == classes.end() ? nullptr : it->second;
+}
+
+const Primitive *find_primitive(std::string_view target)
+{
+    for (auto &primitive : PRIMITIVES) {
+        if (primitive.target == target) {
+            return &primitive;
+        }
+    }
+    return nullptr;
+}
+
+struct Compiler
+{
+    ClassPlan &plan;
+
+    // Fixed size fields next to each other in the file are read together.
+    void add_run(Step::Op op, uint32_t size)
+    {
+        auto &steps = plan.steps;
+        if (!steps.empty() && steps.back().op == op) {
+            steps.back().size += size;
+        } else {
+            steps.push_back({op, size, plan.record_size});
+        }
+
+        if (op == Step::Copy) {
+            plan.record_size += size;
+        }
+    }
+
+    bool add_class(const ClassInfo &info, std::vector<FieldPlan> &fields,
+                   int depth)
+    {
+        if (depth > MAX_DEPTH) {
+            DEBUG("Class nesting too deep at ", info.name);
+            return false;
+        }
+
+        if (!info.base.empty()) {
+            auto base = find_class(info.base);
+            if (!base || !add_class(*base, fields, depth + 1)) {
+                DEBUG("Unsupported base class: ", info.base);
+                return false;
+            }
+        }
+
+        for (auto &field : info.fields) {
+            if (!add_field(field, fields, depth)) {
+                DEBUG("Unsupported type ", field.type, " of ", info.name, ".",
+                      field.name);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool add_field(const FieldInfo &field, std::vector<FieldPlan> &fields,
+                   int depth)
+    {
+        bool ignored = field.name == "_";
+        FieldPlan out{field.name, FieldKind::Object};
+
+        TypeName type;
+        if (!type.parse(field.type)) {
+            return false;
+        }
+
+        auto &node = type.root_node();
+        bool plain = !node.array && node.argument_count == 0;
+        auto primitive = plain ? find_primitive(node.name) : nullptr;
+        auto info = plain ? find_class(node.name) : nullptr;
+
+        if (primitive && primitive->kind == FieldKind::Bool) {
+            out.kind = FieldKind::Bool;
+            out.offset = plan.record_size;
+            plan.steps.push_back({Step::Bool, 1, plan.record_size});
+            plan.record_size += 1;
+        } else if (primitive && primitive->kind == FieldKind::Char) {
+            out.kind = FieldKind::Char;
+            out.offset = plan.record_size;
+            plan.steps.push_back({Step::Char, 4, plan.record_size});
+            plan.record_size += 4;
+        } else if (primitive) {
+            out.kind = primitive->kind;
+            out.offset = plan.record_size;
+            add_run(ignored ? Step::Skip : Step::Copy, primitive->size);
+        } else if (plain && node.name == TypeInfo<std::string_view>::target) {
+            out.kind = FieldKind::String;
+            out.offset = plan.string_count;
+            plan.steps.push_back({Step::String, 0, 0, plan.string_count++});
+        } else if (info && info->value_type) {
+            out.kind = FieldKind::Struct;
+            if (!add_class(*info, out.fields, depth + 1)) {
+                return false;
+            }
+        } else {
+            auto factory = resolve_target(field.type);
+            if (!factory) {
+                return false;
+            }
+
+            out.offset = plan.object_count;
+            if (factory()->value_type()) {
+                uint32_t index = plan.factories.size();
+                plan.factories.push_back(factory);
+                plan.steps.push_back(
+                    {Step::Value, index, 0, plan.object_count++});
+            } else {
+                plan.steps.push_back({Step::Object, 0, 0, plan.object_count++});
+            }
+        }
+
+        if (!ignored) {
+            fields.push_back(std::move(out));
+        }
+        return true;
+    }
+};
+
+template <typename T> T load(const uint8_t *bytes)
+{
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+} // namespace
+
+void register_class(ClassInfo info)
+{
+    auto name = info.name;
+    auto shared = std::make_shared<const ClassInfo>(std::move(info));
+
+    std::unique_lock lock(classes_mutex);
+    classes.insert_or_assign(std::move(name), std::move(shared));
+}
+
+ReaderFactory resolve_class(std::string_view name)
+{
+    std::lock_guard lock(plans_mutex);
+
+    auto it = plans.find(name);
+    if (it == plans.end()) {
+        auto info = find_class(name);
+        if (!info) {
+            return {};
+        }
+
+        auto plan = std::make_shared<ClassPlan>();
+        plan->name = info->name;
+        plan->value_type = info->value_type;
+        it = plans.emplace(info->name, plan).first;
+
+        size_t mark = compiling.size();
+        compiling.push_back(info->name);
+        if (!Compiler{*plan}.add_class(*info, plan->fields, 0)) {
+            for (size_t i = mark; i < compiling.size(); ++i) {
+                plans.erase(compiling[i]);
+            }
+            compiling.resize(mark);
+            return {};
+        }
+        if (mark == 0) {
+            compiling.clear();
+        }
+
+        DEBUG("Compiled ", info->name, " into ", plan->steps.size(),
+              " steps");
+    }
+
+    std::shared_ptr<const ClassPlan> plan = it->second;
+    return [plan] { return std::make_unique<ReflectiveReader>(plan); };
+}
+
+ReflectiveReader::ReflectiveReader(std::shared_ptr<const ClassPlan> plan)
+    : plan(std::move(plan)), record{}, strings{}, objects{}
+{
+}
+
+ReaderType ReflectiveReader::type() { return Reflective; }
+
+bool ReflectiveReader::value_type() { return plan->value_type; }
+
+void ReflectiveReader::read(Buffer &buffer, const Manifest &manifest)
+{
+    record.assign(plan->record_size, 0);
+    strings.assign(plan->string_count, {});
+    objects.clear();
+    objects.resize(plan->object_count);
+
+    uint8_t *out = record.data();
+
+    for (auto &step : plan->steps) {
+        switch (step.op) {
+        case Step::Copy:
+        case Step::Skip:
+            if (step.size > buffer.remaining()) {
+                DEBUG("Fields of ", plan->name, " overrun buffer");
+                return;
+            }
+            if (step.op == Step::Copy) {
+                std::memcpy(out + step.offset, buffer.read(step.size).data(),
+                            step.size);
+            } else {
+                buffer.seek(step.size);
+            }
+            break;
+        case Step::Bool:
+            if (!buffer.remaining()) {
+                DEBUG("Fields of ", plan->name, " overrun buffer");
+                return;
+            }
+            out[step.offset] = buffer.read_byte() != 0;
+            break;
+        case Step::Char: {
+            if (!buffer.remaining()) {
+                DEBUG("Fields of ", plan->name, " overrun buffer");
+                return;
+            }
+            char32_t value = Element<char32_t>{}.read(buffer, manifest);
+            std::memcpy(out + step.offset, &value, sizeof(value));
+            break;
+        }
+        case Step::String:
+            strings[step.slot] =
+                Element<std::string_view>{}.read(buffer, manifest);
+            break;
+        case Step::Object:
+            objects[step.slot] = manifest.read_object(buffer);
+            break;
+        case Step::Value: {
+            auto reader = plan->factories[step.size]();
+            reader->read(buffer, manifest);
+            objects[step.slot] = std::move(reader);
+            break;
+        }
+        }
+    }
+}
+
+void ReflectiveReader::emit(Emitter &out) { emit_record(out, plan->fields); }
+
+void ReflectiveReader::emit_record(Emitter &out,
+                                   const std::vector<FieldPlan> &fields)
+{
+    out.begin_object();
+
+    for (auto &field : fields) {
+        const uint8_t *at = record.data() + field.offset;
+        out.key(field.name);
+
+        switch (field.kind) {
+        case FieldKind::Bool:
+            readers::emit(out, at[0] != 0);
+            break;
+        case FieldKind::Int8:
+            readers::emit(out, load<int8_t>(at));
+            break;
+        case FieldKind::UInt8:
+            readers::emit(out, load<uint8_t>(at));
+            break;
+        case FieldKind::Int16:
+            readers::emit(out, load<int16_t>(at));
+            break;
+        case FieldKind::UInt16:
+            readers::emit(out, load<uint16_t>(at));
+            break;
+        case FieldKind::Int32:
+            readers::emit(out, load<int32_t>(at));
+            break;
+        case FieldKind::UInt32:
+            readers::emit(out, load<uint32_t>(at));
+            break;
+        case FieldKind::Int64:
+            readers::emit(out, load<int64_t>(at));
+            break;
+        case FieldKind::UInt64:
+            readers::emit(out, load<uint64_t>(at));
+            break;
+        case FieldKind::Single:
+            readers::emit(out, load<float>(at));
+            break;
+        case FieldKind::Double:
+            readers::emit(out, load<double>(at));
+            break;
+        case FieldKind::Char:
+            readers::emit(out, load<char32_t>(at));
+            break;
+        case FieldKind::Vector2:
+            readers::emit(out, load<Vector2>(at));
+            break;
+        case FieldKind::Vector3:
+            readers::emit(out, load<Vector3>(at));
+            break;
+        case FieldKind::Vector4:
+            readers::emit(out, load<Vector4>(at));
+            break;
+        case FieldKind::Quaternion:
+            readers::emit(out, load<Quaternion>(at));
+            break;
+        case FieldKind::Matrix:
+            readers::emit(out, load<Matrix>(at));
+            break;
+        case FieldKind::Point:
+            readers::emit(out, load<Point>(at));
+            break;
+        case FieldKind::Rectangle:
+            readers::emit(out, load<Rectangle>(at));
+            break;
+        case FieldKind::Color:
+            readers::emit(out, load<Color>(at));
+            break;
+        case FieldKind::String:
+            out.string(strings[field.offset]);
+            break;
+        case FieldKind::Object:
+            readers::emit(out, objects[field.offset]);
+            break;
+        case FieldKind::Struct:
+            emit_record(out, field.fields);
+            break;
+        }
+    }
+
+    out.end_object();
+}
+} // namespace readers
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/collections.hpp"
+#include "readers/reader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace readers
+{
+// A field of a game class, with its type named as in generic arguments,
+// such as "System.Int32" or "System.Collections.Generic.List`1[[...]]".
+// Fields named "_" are read but left out of the export.
+struct FieldInfo
+{
+    std::string name;
+    std::string type;
+};
+
+/*
+ * What ReflectiveReader`1 needs to know about a class, which the XNB
+ * doesn't say: its fields in the order they are serialized, and its base
+ * class, whose fields come first. Structs are stored inline wherever they
+ * are used, like the other value types.
+ */
+struct ClassInfo
+{
+    std::string name;
+    std::string base;
+    std::vector<FieldInfo> fields;
+    bool value_type = false;
+};
+
+// NOTE: Readers are resolved once per process, so classes have to be
+// registered before the first file that uses them is opened.
+void register_class(ClassInfo info);
+
+// Resolves the reader for a registered class. Empty if the class isn't
+// registered or one of its fields has an unsupported type.
+ReaderFactory resolve_class(std::string_view name);
+
+// How a field's value is stored in a decoded record.
+enum class FieldKind : uint8_t
+{
+    Bool,
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Int64,
+    UInt64,
+    Single,
+    Double,
+    Char,
+    Vector2,
+    Vector3,
+    Vector4,
+    Quaternion,
+    Matrix,
+    Point,
+    Rectangle,
+    Color,
+    String,
+    Object,
+    Struct
+};
+
+// One step of a decode plan. Runs of fixed size fields are laid out in
+// the record as they are in the file, so a whole run is a single Copy.
+struct Step
+{
+    enum Op : uint8_t
+    {
+        Copy,   // size bytes into the record at offset
+        Skip,   // size bytes of ignored fields
+        Bool,   // a byte, normalized, into the record at offset
+        Char,   // a UTF-8 character into the record at offset
+        String, // a string into strings[slot]
+        Object, // a reference type into objects[slot], through the manifest
+        Value   // a value type into objects[slot], through factories[size]
+    };
+
+    Op op;
+    uint32_t size = 0;
+    uint32_t offset = 0;
+    uint32_t slot = 0;
+};
+
+// Where a field ended up, for writing the record back out. Struct fields
+// list the fields of the struct.
+struct FieldPlan
+{
+    std::string name;
+    FieldKind kind;
+    uint32_t offset = 0;
+    std::vector<FieldPlan> fields = {};
+};
+
+/*
+ * A class compiled down to a flat list of steps, with base classes and
+ * nested structs inlined. Decoding a record is one pass over the steps
+ * without any lookups by name or virtual calls, apart from the fields
+ * that hold other objects.
+ */
+struct ClassPlan
+{
+    std::string name;
+    bool value_type = false;
+
+    std::vector<Step> steps;
+    std::vector<FieldPlan> fields;
+    std::vector<ReaderFactory> factories;
+
+    uint32_t record_size = 0;
+    uint32_t string_count = 0;
+    uint32_t object_count = 0;
+};
+
+struct ReflectiveReader : Reader
+{
+    std::shared_ptr<const ClassPlan> plan;
+
+    std::vector<uint8_t> record;
+    std::vector<std::string_view> strings;
+    std::vector<ReaderPtr> objects;
+
+    ReflectiveReader(std::shared_ptr<const ClassPlan> plan);
+    ~ReflectiveReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+    virtual bool value_type();
+    virtual void emit(Emitter &out);
+
+    void emit_record(Emitter &out, const std::vector<FieldPlan> &fields);
+};
+
+} // namespace readers
@@ -0,0 +1,290 @@
+#include "readers/registry.hpp"
+
+#include "readers/collections.hpp"
+#include "readers/effect.hpp"
+#include "readers/geometry.hpp"
+#include "readers/model.hpp"
+#include "readers/primitives.hpp"
+#include "readers/reflective.hpp"
+#include "readers/soundeffect.hpp"
+#include "readers/spritefont.hpp"
+#include "readers/texture2d.hpp"
+#include "readers/textures.hpp"
+#include "readers/type_name.hpp"
+#include "util.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace readers
+{
+namespace
+{
+template <typename... Ts> struct TypeList
+{
+};
+
+using Elements =
+    TypeList<bool, uint8_t, int8_t, int16_t, uint16_t, int32_t, uint32_t,
+             int64_t, uint64_t, float, double, char32_t, std::string_view,
+             Vector2, Vector3, Vector4, Quaternion, Matrix, Point, Rectangle,
+             Color>;
+
+// Every key type gets instantiated with every value type, so dictionaries
+// only get dedicated code for the combinations common in game data. Other
+// types still work, they are just read through their type reader.
+using DictionaryKeys = TypeList<int32_t, std::string_view>;
+using DictionaryValues =
+    TypeList<bool, int32_t, float, std::string_view>;
+
+const std::string_view CONTENT_NAMESPACE =
+    "Microsoft.Xna.Framework.Content.";
+
+template <typename T> ReaderPtr make() { return std::make_unique<T>(); }
+
+// Non-generic readers, by the name of the reader (without namespace) and
+// of the type it reads.
+struct Entry
+{
+    std::string_view reader;
+    std::string_view target;
+    ReaderPtr (*make)();
+};
+
+const Entry READERS[] = {
+    {"Texture2DReader", "Microsoft.Xna.Framework.Graphics.Texture2D",
+     make<Texture2DReader>},
+    {"Texture3DReader", "Microsoft.Xna.Framework.Graphics.Texture3D",
+     make<Texture3DReader>},
+    {"TextureCubeReader", "Microsoft.Xna.Framework.Graphics.TextureCube",
+     make<TextureCubeReader>},
+    {"SpriteFontReader", "Microsoft.Xna.Framework.Graphics.SpriteFont",
+     make<SpriteFontReader>},
+    {"SoundEffectReader", "Microsoft.Xna.Framework.Audio.SoundEffect",
+     make<SoundEffectReader>},
+    {"VertexDeclarationReader",
+     "Microsoft.Xna.Framework.Graphics.VertexDeclaration",
+     make<VertexDeclarationReader>},
+    {"VertexBufferReader", "Microsoft.Xna.Framework.Graphics.VertexBuffer",
+     make<VertexBufferReader>},
+    {"IndexBufferReader", "Microsoft.Xna.Framework.Graphics.IndexBuffer",
+     make<IndexBufferReader>},
+    {"ModelReader", "Microsoft.Xna.Framework.Graphics.Model",
+     make<ModelReader>},
+    {"BasicEffectReader", "Microsoft.Xna.Framework.Graphics.BasicEffect",
+     make<BasicEffectReader>},
+    {"EffectReader", "Microsoft.Xna.Framework.Graphics.Effect",
+     make<EffectReader>},
+};
+
+template <typename... Ts, typename F>
+bool visit_target(TypeList<Ts...>, std::string_view target, F &&f)
+{
+    return ((target == TypeInfo<Ts>::target &&
+             (f.template operator()<Ts>(), true)) ||
+            ...);
+}
+
+template <typename... Ts, typename F>
+bool visit_reader(TypeList<Ts...>, std::string_view reader, F &&f)
+{
+    return ((reader == TypeInfo<Ts>::reader &&
+             (f.template operator()<Ts>(), true)) ||
+            ...);
+}
+
+template <typename T> ReaderFactory primitive_factory()
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        return [] { return std::make_unique<StringReader>(); };
+    } else {
+        return [] { return std::make_unique<PrimitiveReader<T>>(); };
+    }
+}
+
+ReaderFactory resolve_target(const TypeName &type, const TypeNode &node);
+
+// Calls f with the Element for the target type: a dedicated one if the
+// type is in the list, otherwise one that goes through its type reader.
+template <typename... Ts, typename F>
+bool with_element(TypeList<Ts...> types, const TypeName &type,
+                  const TypeNode &node, F &&f)
+{
+    if (node.argument_count == 0 &&
+        visit_target(types, node.name,
+                     [&]<typename T>() { f(Element<T>{}); })) {
+        return true;
+    }
+
+    auto factory = resolve_target(type, node);
+    if (!factory) {
+        DEBUG("Unsupported element type: ", node.name);
+        return false;
+    }
+
+    bool value_type = factory()->value_type();
+    f(Element<ReaderPtr>{factory, value_type});
+    return true;
+}
+
+template <ReaderType Kind>
+ReaderFactory sequence_factory(const TypeName &type, const TypeNode &node)
+{
+    ReaderFactory factory;
+    with_element(Elements{}, type, type.argument(node, 0),
+                 [&]<typename T>(Element<T> element) {
+                     factory = [element] {
+                         return std::make_unique<SequenceReader<T, Kind>>(
+                             element);
+                     };
+                 });
+    return factory;
+}
+
+ReaderFactory dictionary_factory(const TypeName &type, const TypeNode &node)
+{
+    ReaderFactory factory;
+    with_element(
+        DictionaryKeys{}, type, type.argument(node, 0),
+        [&]<typename K>(Element<K> key) {
+            with_element(DictionaryValues{}, type, type.argument(node, 1),
+                         [&]<typename V>(Element<V> value) {
+                             factory = [key, value] {
+                                 return std::make_unique<
+                                     DictionaryReader<K, V>>(key, value);
+                             };
+                         });
+        });
+    return factory;
+}
+
+ReaderFactory resolve_target(const TypeName &type, const TypeNode &node)
+{
+    if (node.array) {
+        return sequence_factory<Array>(type, node);
+    }
+
+    ReaderFactory factory;
+    if (node.argument_count == 0 &&
+        visit_target(Elements{}, node.name, [&]<typename T>() {
+            factory = primitive_factory<T>();
+        })) {
+        return factory;
+    }
+
+    for (auto &entry : READERS) {
+        if (node.name == entry.target) {
+            return entry.make;
+        }
+    }
+
+    auto args = node.argument_count;
+
+    if (node.name == "System.Collections.Generic.List`1" && args == 1) {
+        return sequence_factory<List>(type, node);
+    } else if (node.name == "System.Collections.Generic.Dictionary`2" &&
+               args == 2) {
+        return dictionary_factory(type, node);
+    } else if (args == 0) {
+        return resolve_class(node.name);
+    }
+
+    return {};
+}
+
+ReaderFactory resolve_reader(const TypeName &type, const TypeNode &node)
+{
+    ReaderFactory factory;
+    if (node.argument_count == 0 &&
+        visit_reader(Elements{}, node.name, [&]<typename T>() {
+            factory = primitive_factory<T>();
+        })) {
+        return factory;
+    }
+
+    if (!node.name.starts_with(CONTENT_NAMESPACE)) {
+        return {};
+    }
+
+    auto reader = node.name.substr(CONTENT_NAMESPACE.size());
+
+    for (auto &entry : READERS) {
+        if (reader == entry.reader) {
+            return entry.make;
+        }
+    }
+
+    auto args = node.argument_count;
+
+    if (reader == "ListReader`1" && args == 1) {
+        return sequence_factory<List>(type, node);
+    } else if (reader == "ArrayReader`1" && args == 1) {
+        return sequence_factory<Array>(type, node);
+    } else if (reader == "DictionaryReader`2" && args == 2) {
+        return dictionary_factory(type, node);
+    } else if (reader == "ReflectiveReader`1" && args == 1) {
+        return resolve_class(type.argument(node, 0).name);
+    }
+
+    return {};
+}
+
+// Transparent hashing lets the cache be probed with a string_view.
+struct NameHash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view name) const
+    {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+// The same handful of reader names shows up in thousands of files, so
+// each one is parsed and resolved once per process. Only readers that
+// resolve are kept. One that doesn't may still resolve once a schema
+// with its class is loaded.
+std::shared_mutex cache_mutex;
+std::unordered_map<std::string, ReaderFactory, NameHash, std::equal_to<>>
+    cache;
+} // namespace
+
+ReaderFactory resolve_reader(std::string_view name)
+{
+    {
+        std::shared_lock lock(cache_mutex);
+        if (auto it = cache.find(name); it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    TypeName type;
+    ReaderFactory factory;
+    if (type.parse(name)) {
+        factory = resolve_reader(type, type.root_node());
+    } else {
+        DEBUG("Malformed type name: ", name);
+    }
+
+    if (factory) {
+        std::unique_lock lock(cache_mutex);
+        cache.emplace(name, factory);
+    }
+    return factory;
+}
+
+ReaderFactory resolve_target(std::string_view name)
+{
+    TypeName type;
+    if (!type.parse(name)) {
+        return {};
+    }
+    return resolve_target(type, type.root_node());
+}
+} // namespace readers
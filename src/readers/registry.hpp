@@ -0,0 +1,17 @@
+#pragma once
+
+#include "readers/reader.hpp"
+
+#include <string_view>
+
+namespace readers
+{
+// Resolves a type reader named in the XNB header, such as
+// "Microsoft.Xna.Framework.Content.ListReader`1[[System.Int32, mscorlib]]".
+// Returns an empty factory if the reader isn't supported.
+ReaderFactory resolve_reader(std::string_view name);
+
+// Resolves the reader for a target type named in a generic argument, such
+// as "System.Int32" or "System.Collections.Generic.List`1[[...]]".
+ReaderFactory resolve_target(std::string_view name);
+} // namespace readers
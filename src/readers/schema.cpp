@@ -0,0 +1,99 @@
+#include "readers/schema.hpp"
+
+#include "readers/reflective.hpp"
+#include "util.hpp"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace readers
+{
+namespace
+{
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' ||
+                             text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Splits off the first word of text, leaving the rest trimmed.
+std::string_view next_word(std::string_view &text)
+{
+    size_t end = text.find_first_of(" \t");
+    auto word = text.substr(0, end);
+    text = end == std::string_view::npos ? "" : trim(text.substr(end));
+    return word;
+}
+} // namespace
+
+bool load_schema(const std::filesystem::path &path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        WARN("Can't open schema ", path.string());
+        return false;
+    }
+
+    std::vector<ClassInfo> classes;
+    std::string line;
+    int number = 0;
+
+    while (std::getline(in, line)) {
+        ++number;
+
+        bool indented = !line.empty() && (line[0] == ' ' || line[0] == '\t');
+        auto text = trim(line);
+        if (text.empty() || text.front() == '#') {
+            continue;
+        }
+
+        auto word = next_word(text);
+
+        if (indented) {
+            if (classes.empty() || text.empty()) {
+                WARN(path.string(), ":", number, ": Expected a field");
+                return false;
+            }
+            classes.back().fields.push_back(
+                {std::string(word), std::string(text)});
+            continue;
+        }
+
+        if (word != "class" && word != "struct") {
+            WARN(path.string(), ":", number, ": Expected a class or struct");
+            return false;
+        }
+
+        ClassInfo info;
+        info.value_type = word == "struct";
+        info.name = next_word(text);
+
+        if (!text.empty()) {
+            if (next_word(text) != ":" || text.empty()) {
+                WARN(path.string(), ":", number, ": Expected a base class");
+                return false;
+            }
+            info.base = next_word(text);
+        }
+
+        if (info.name.empty() || !text.empty()) {
+            WARN(path.string(), ":", number, ": Malformed class");
+            return false;
+        }
+        classes.push_back(std::move(info));
+    }
+
+    for (auto &info : classes) {
+        register_class(std::move(info));
+    }
+    return true;
+}
+} // namespace readers
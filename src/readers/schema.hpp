@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+
+namespace readers
+{
+/*
+ * Registers the classes described in a schema file, for ReflectiveReader`1
+ * to decode. Every class starts a block, with its fields indented below it
+ * in the order they are serialized, as a name followed by a type:
+ *
+ *   # Comments start with a hash
+ *   class StardewValley.GameData.Crops.CropData
+ *       Seasons System.Collections.Generic.List`1[[...]]
+ *       DaysInPhase System.Collections.Generic.List`1[[System.Int32]]
+ *       _ System.Int32
+ *
+ *   struct Game.Point3 : Game.Base
+ *       X System.Int32
+ *
+ * Structs are value types, which are stored inline. A class can name its
+ * base class after a colon, whose fields are read first. Fields named _
+ * are read but not exported.
+ */
+bool load_schema(const std::filesystem::path &path);
+} // namespace readers
@@ -0,0 +1,58 @@
+#include "readers/soundeffect.hpp"
+
+#include "packing.hpp"
+#include "util.hpp"
+
+namespace readers
+{
+SoundEffectReader::SoundEffectReader()
+    : format{}, format_tag(0), channels(0), sample_rate(0), block_align(0),
+      bits_per_sample(0), data{}, loop_start(0), loop_length(0), duration(0)
+{
+}
+
+ReaderType SoundEffectReader::type() { return SoundEffect; }
+
+void SoundEffectReader::read(Buffer &buffer, const Manifest &)
+{
+    // The format and the data each follow their size, and the loop and
+    // the duration come last. Nothing is kept unless all of it fits.
+    if (buffer.remaining() < 4) {
+        DEBUG("Sound effect overruns buffer");
+        return;
+    }
+    size_t format_size = buffer.read_u32();
+    if (format_size > buffer.remaining() ||
+        buffer.remaining() - format_size < 4) {
+        DEBUG("Sound format of ", format_size, " bytes overruns buffer");
+        return;
+    }
+    auto header = buffer.read(format_size);
+
+    size_t data_size = buffer.read_u32();
+    if (data_size > buffer.remaining() ||
+        buffer.remaining() - data_size < 12) {
+        DEBUG("Sound data of ", data_size, " bytes overruns buffer");
+        return;
+    }
+    data = buffer.read(data_size);
+    format.assign(header.begin(), header.end());
+
+    if (format_size >= 16) {
+        format_tag = packing::pack_uint(header.subspan(0, 2));
+        channels = packing::pack_uint(header.subspan(2, 2));
+        sample_rate = packing::pack_uint(header.subspan(4, 4));
+        block_align = packing::pack_uint(header.subspan(12, 2));
+        bits_per_sample = packing::pack_uint(header.subspan(14, 2));
+    }
+
+    loop_start = buffer.read_i32();
+    loop_length = buffer.read_i32();
+    duration = buffer.read_i32();
+
+    DEBUG("Format tag: ", format_tag);
+    DEBUG("Channels: ", channels);
+    DEBUG("Sample rate: ", sample_rate);
+    DEBUG("Data size: ", data_size);
+}
+} // namespace readers
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/reader.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace readers
+{
+struct SoundEffectReader : Reader
+{
+    // The raw WAVEFORMATEX header, with its common fields picked out.
+    std::vector<uint8_t> format;
+    int format_tag;
+    int channels;
+    int sample_rate;
+    int block_align;
+    int bits_per_sample;
+
+    // Sample data, viewed in place in the decompressed buffer. It is only
+    // valid for as long as that buffer is.
+    std::span<const uint8_t> data;
+
+    // In samples.
+    int loop_start;
+    int loop_length;
+
+    // In milliseconds.
+    int duration;
+
+    SoundEffectReader();
+    ~SoundEffectReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+} // namespace readers
@@ -0,0 +1,45 @@
+#include "readers/spritefont.hpp"
+
+#include "readers/collections.hpp"
+#include "util.hpp"
+
+#include <utility>
+
+namespace readers
+{
+namespace
+{
+// The lists are stored as full objects, each with its own type index.
+template <typename T>
+std::vector<T> read_list(Buffer &buffer, const Manifest &manifest)
+{
+    auto list = manifest.read_object<ListReader<T>>(buffer);
+    if (!list) {
+        return {};
+    }
+    return std::move(list->values);
+}
+} // namespace
+
+SpriteFontReader::SpriteFontReader() : line_spacing(0), spacing(0) {}
+
+ReaderType SpriteFontReader::type() { return SpriteFont; }
+
+void SpriteFontReader::read(Buffer &buffer, const Manifest &manifest)
+{
+    texture = manifest.read_object<Texture2DReader>(buffer);
+    glyphs = read_list<Rectangle>(buffer, manifest);
+    cropping = read_list<Rectangle>(buffer, manifest);
+    characters = read_list<char32_t>(buffer, manifest);
+    line_spacing = buffer.read_i32();
+    spacing = Element<float>{}.read(buffer, manifest);
+    kerning = read_list<Vector3>(buffer, manifest);
+
+    if (Element<bool>{}.read(buffer, manifest)) {
+        default_character = Element<char32_t>{}.read(buffer, manifest);
+    }
+
+    DEBUG("Glyph count: ", characters.size());
+    DEBUG("Line spacing: ", line_spacing);
+}
+} // namespace readers
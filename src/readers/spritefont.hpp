@@ -0,0 +1,39 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/primitives.hpp"
+#include "readers/reader.hpp"
+#include "readers/texture2d.hpp"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace readers
+{
+struct SpriteFontReader : Reader
+{
+    std::unique_ptr<Texture2DReader> texture;
+
+    // Where each glyph sits in the texture, and the offset and size of the
+    // cell it is drawn into.
+    std::vector<Rectangle> glyphs;
+    std::vector<Rectangle> cropping;
+    std::vector<char32_t> characters;
+
+    int line_spacing;
+    float spacing;
+
+    // Left side bearing, glyph width and right side bearing per glyph.
+    std::vector<Vector3> kerning;
+
+    std::optional<char32_t> default_character;
+
+    SpriteFontReader();
+    ~SpriteFontReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+} // namespace readers
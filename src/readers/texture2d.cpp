@@ -1,6 +1,7 @@
 #include "readers/texture2d.hpp"
 
 #include "reader.hpp"
+#include "readers/textures.hpp"
 #include "util.hpp"
 
 namespace readers
@@ -13,14 +14,21 @@ Texture2DReader::Texture2DReader()
 
 ReaderType Texture2DReader::type() { return Texture2D; }
 
-void Texture2DReader::read(Buffer buffer)
+void Texture2DReader::read(Buffer &buffer, const Manifest &)
 {
+    if (buffer.remaining() < 16) {
+        DEBUG("Texture header overruns buffer");
+        return;
+    }
     surface_format = buffer.read_i32();
     width = buffer.read_u32();
     height = buffer.read_u32();
     mipcount = buffer.read_u32();
-    data_size = buffer.read_u32();
-    bytes = buffer.copy_out(data_size);
+
+    // Only the full size image is kept, the smaller mip levels are skipped.
+    auto top = read_mip_chain(buffer, mipcount);
+    data_size = top.size();
+    bytes.assign(top.begin(), top.end());
 
     DEBUG("Surface Format: ", surface_format);
     DEBUG("Width: ", width);
@@ -20,7 +20,7 @@ struct Texture2DReader : Reader
     Texture2DReader();
     ~Texture2DReader(){};
 
-    virtual void read(Buffer buffer);
+    virtual void read(Buffer &buffer, const Manifest &manifest);
     virtual ReaderType type();
 };
 
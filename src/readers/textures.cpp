@@ -0,0 +1,89 @@
+#include "readers/textures.hpp"
+
+#include "util.hpp"
+
+namespace readers
+{
+// NOTE: Where anything after a broken chain starts isn't known, so the
+// cursor is left at the end of the buffer and the chain is dropped.
+std::span<const uint8_t> read_mip_chain(Buffer &buffer, int mipcount)
+{
+    std::span<const uint8_t> top;
+
+    for (int level = 0; level < mipcount; ++level) {
+        size_t size = buffer.remaining() < 4 ? SIZE_MAX : buffer.read_u32();
+        if (size > buffer.remaining()) {
+            DEBUG("Mip level ", level, " overruns buffer");
+            buffer.seek(buffer.remaining());
+            return {};
+        }
+
+        auto bytes = buffer.read(size);
+        if (level == 0) {
+            top = bytes;
+        }
+    }
+
+    return top;
+}
+
+Texture3DReader::Texture3DReader()
+    : surface_format(0), width(0), height(0), depth(0), mipcount(0),
+      bytes{}
+{
+}
+
+ReaderType Texture3DReader::type() { return Texture3D; }
+
+std::span<const uint8_t> Texture3DReader::slice(int index) const
+{
+    size_t size = depth > 0 ? bytes.size() / depth : 0;
+    return bytes.subspan(index * size, size);
+}
+
+void Texture3DReader::read(Buffer &buffer, const Manifest &)
+{
+    if (buffer.remaining() < 20) {
+        DEBUG("Texture header overruns buffer");
+        return;
+    }
+    surface_format = buffer.read_i32();
+    width = buffer.read_u32();
+    height = buffer.read_u32();
+    depth = buffer.read_u32();
+    mipcount = buffer.read_u32();
+
+    bytes = read_mip_chain(buffer, mipcount);
+
+    DEBUG("Surface Format: ", surface_format);
+    DEBUG("Size: ", width, "x", height, "x", depth);
+    DEBUG("Mip count: ", mipcount);
+}
+
+TextureCubeReader::TextureCubeReader()
+    : surface_format(0), size(0), mipcount(0), faces{}
+{
+}
+
+ReaderType TextureCubeReader::type() { return TextureCube; }
+
+// NOTE: Each face carries a complete mip chain of its own.
+void TextureCubeReader::read(Buffer &buffer, const Manifest &)
+{
+    if (buffer.remaining() < 12) {
+        DEBUG("Texture header overruns buffer");
+        return;
+    }
+    surface_format = buffer.read_i32();
+    size = buffer.read_u32();
+    mipcount = buffer.read_u32();
+
+    for (auto &face : faces) {
+        face = read_mip_chain(buffer, mipcount);
+    }
+
+    DEBUG("Surface Format: ", surface_format);
+    DEBUG("Size: ", size);
+    DEBUG("Mip count: ", mipcount);
+}
+} // namespace readers
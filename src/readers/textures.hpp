@@ -0,0 +1,54 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "readers/reader.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace readers
+{
+// Reads the levels of a mip chain and gives a view of the first, full
+// size level. The smaller levels are skipped. A chain that overruns the
+// buffer gives an empty view.
+std::span<const uint8_t> read_mip_chain(Buffer &buffer, int mipcount);
+
+struct Texture3DReader : Reader
+{
+    int surface_format;
+    int width;
+    int height;
+    int depth;
+    int mipcount;
+
+    // Every slice of the top level back to back, viewed in place in the
+    // decompressed buffer.
+    std::span<const uint8_t> bytes;
+
+    Texture3DReader();
+    ~Texture3DReader(){};
+
+    std::span<const uint8_t> slice(int index) const;
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+struct TextureCubeReader : Reader
+{
+    int surface_format;
+    int size;
+    int mipcount;
+
+    // Top level of each face, in the order +X, -X, +Y, -Y, +Z, -Z.
+    std::array<std::span<const uint8_t>, 6> faces;
+
+    TextureCubeReader();
+    ~TextureCubeReader(){};
+
+    virtual void read(Buffer &buffer, const Manifest &manifest);
+    virtual ReaderType type();
+};
+
+} // namespace readers
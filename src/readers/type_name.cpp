@@ -0,0 +1,169 @@
+#include "readers/type_name.hpp"
+
+#include <string_view>
+
+namespace readers
+{
+namespace
+{
+struct Parser
+{
+    TypeName &out;
+    std::string_view text;
+    size_t pos = 0;
+
+    bool at(char c) const { return pos < text.size() && text[pos] == c; }
+
+    void skip_spaces()
+    {
+        while (at(' ')) {
+            ++pos;
+        }
+    }
+
+    int8_t add(TypeNode node)
+    {
+        if (out.size == TypeName::MAX_NODES) {
+            return -1;
+        }
+        out.nodes[out.size] = node;
+        return static_cast<int8_t>(out.size++);
+    }
+
+    /*
+     * type     := name generic? array* (", " assembly)?
+     * generic  := "[" argument ("," argument)* "]"
+     * argument := "[" type "]" | type
+     * array    := "[" ","* "]"
+     *
+     * Only bracketed arguments and the outermost type may carry an
+     * assembly, as its commas are otherwise ambiguous.
+     */
+    int8_t parse_type(bool qualified)
+    {
+        skip_spaces();
+
+        size_t start = pos;
+        while (pos < text.size() && text[pos] != '[' && text[pos] != ']' &&
+               text[pos] != ',') {
+            ++pos;
+        }
+
+        TypeNode node;
+        node.name = text.substr(start, pos - start);
+        while (node.name.ends_with(' ')) {
+            node.name.remove_suffix(1);
+        }
+        if (node.name.empty()) {
+            return -1;
+        }
+
+        if (auto tick = node.name.find('`'); tick != std::string_view::npos) {
+            unsigned arity = 0;
+            for (char c : node.name.substr(tick + 1)) {
+                if (c < '0' || c > '9') {
+                    return -1;
+                }
+                if ((arity = arity * 10 + (c - '0')) > 255) {
+                    return -1;
+                }
+            }
+            node.arity = static_cast<uint8_t>(arity);
+        }
+
+        int8_t index = add(node);
+        if (index < 0) {
+            return -1;
+        }
+
+        if (at('[') && pos + 1 < text.size() && text[pos + 1] != ']' &&
+            text[pos + 1] != ',') {
+            ++pos;
+            int8_t last = -1;
+
+            while (true) {
+                skip_spaces();
+
+                int8_t argument;
+                if (at('[')) {
+                    ++pos;
+                    argument = parse_type(true);
+                    if (argument < 0 || !at(']')) {
+                        return -1;
+                    }
+                    ++pos;
+                } else {
+                    argument = parse_type(false);
+                    if (argument < 0) {
+                        return -1;
+                    }
+                }
+
+                if (last < 0) {
+                    out.nodes[index].first_argument = argument;
+                } else {
+                    out.nodes[last].next = argument;
+                }
+                out.nodes[index].argument_count++;
+                last = argument;
+
+                skip_spaces();
+                if (at(',')) {
+                    ++pos;
+                } else if (at(']')) {
+                    ++pos;
+                    break;
+                } else {
+                    return -1;
+                }
+            }
+        }
+
+        while (at('[')) {
+            ++pos;
+            while (at(',')) {
+                ++pos;
+            }
+            if (!at(']')) {
+                return -1;
+            }
+            ++pos;
+
+            TypeNode array;
+            array.array = true;
+            array.argument_count = 1;
+            array.first_argument = index;
+            if ((index = add(array)) < 0) {
+                return -1;
+            }
+        }
+
+        if (qualified && at(',')) {
+            while (pos < text.size() && text[pos] != ']') {
+                ++pos;
+            }
+        }
+
+        return index;
+    }
+};
+} // namespace
+
+bool TypeName::parse(std::string_view type)
+{
+    size = 0;
+
+    Parser parser{*this, type};
+    root = parser.parse_type(true);
+    return root >= 0 && parser.pos == type.size();
+}
+
+const TypeNode &TypeName::argument(const TypeNode &node, size_t index) const
+{
+    int8_t argument = node.first_argument;
+    while (index--) {
+        argument = nodes[argument].next;
+    }
+    return nodes[argument];
+}
+} // namespace readers
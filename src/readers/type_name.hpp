@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace readers
+{
+/*
+ * A parsed .NET type name, such as
+ *
+ * 	Microsoft.Xna.Framework.Content.DictionaryReader`2[[System.String,
+ * 	mscorlib, Version=4.0.0.0],[System.Int32, mscorlib, Version=4.0.0.0]]
+ *
+ * The tree is stored in a fixed array of nodes whose names are views into
+ * the original string, so parsing never allocates. The original string
+ * has to outlive the TypeName. Assembly qualifications are dropped.
+ */
+struct TypeNode
+{
+    // Namespace qualified name including the `N arity suffix, or empty for
+    // arrays.
+    std::string_view name;
+
+    // The N of a `N suffix, 0 for non-generic types.
+    uint8_t arity = 0;
+
+    // T[]: the single argument is the element type T.
+    bool array = false;
+
+    uint8_t argument_count = 0;
+    int8_t first_argument = -1;
+
+    // The next argument of the parent type, if any.
+    int8_t next = -1;
+};
+
+struct TypeName
+{
+    static constexpr size_t MAX_NODES = 32;
+
+    std::array<TypeNode, MAX_NODES> nodes;
+    size_t size = 0;
+    int8_t root = -1;
+
+    // Returns false if the name is malformed or nested too deeply.
+    bool parse(std::string_view type);
+
+    const TypeNode &root_node() const { return nodes[root]; }
+    const TypeNode &argument(const TypeNode &node, size_t index) const;
+};
+} // namespace readers
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+#include <variant>
+
+/*
+ * The outcome of a step that can fail: either its value or an error.
+ * Shaped after std::expected, which C++20 doesn't have, so a failure is
+ * returned as unexpected(error) and checked for before the value is used.
+ */
+template <typename E> struct Unexpected
+{
+    E error;
+};
+
+template <typename E> Unexpected<E> unexpected(E error)
+{
+    return {std::move(error)};
+}
+
+template <typename T, typename E> struct Expected
+{
+    std::variant<T, E> state;
+
+    Expected(T value) : state(std::in_place_index<0>, std::move(value)) {}
+    Expected(Unexpected<E> failure)
+        : state(std::in_place_index<1>, std::move(failure.error))
+    {
+    }
+
+    bool has_value() const { return state.index() == 0; }
+    explicit operator bool() const { return has_value(); }
+
+    T &value() { return std::get<0>(state); }
+    const T &value() const { return std::get<0>(state); }
+    T &operator*() { return value(); }
+    const T &operator*() const { return value(); }
+    T *operator->() { return &value(); }
+    const T *operator->() const { return &value(); }
+
+    E &error() { return std::get<1>(state); }
+    const E &error() const { return std::get<1>(state); }
+};
+
+// A step with nothing to return but whether it worked.
+template <typename E> struct Expected<void, E>
+{
+    std::optional<E> failure;
+
+    Expected() = default;
+    Expected(Unexpected<E> failure) : failure(std::move(failure.error)) {}
+
+    bool has_value() const { return !failure; }
+    explicit operator bool() const { return has_value(); }
+
+    E &error() { return *failure; }
+    const E &error() const { return *failure; }
+};
@@ -0,0 +1,333 @@
+#include "server.hpp"
+
+#include "util.hpp"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace server
+{
+#ifdef _WIN32
+int serve(xnb::Context &context, const fs::path &socket)
+{
+    WARN("Serving needs Unix domain sockets");
+    return 1;
+}
+#else
+namespace
+{
+// Longest request line. A connection that sends more without a line
+// break is answered with an error and closed.
+constexpr size_t MAX_LINE = 64 * 1024;
+
+struct Server
+{
+    xnb::Context &context;
+    int listener = -1;
+    std::atomic<bool> stopping = false;
+
+    // Open connections, so a shutdown can end the ones sitting idle.
+    std::mutex mutex;
+    std::condition_variable done;
+    std::set<int> sessions;
+
+    explicit Server(xnb::Context &context) : context(context) {}
+};
+
+std::vector<std::string_view> split(std::string_view line)
+{
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find('\t', start);
+        fields.push_back(line.substr(start, end - start));
+        if (end == std::string_view::npos) {
+            return fields;
+        }
+        start = end + 1;
+    }
+}
+
+std::string failure(const xnb::Error &error)
+{
+    return "error\t" + error.message;
+}
+
+std::string probe(xnb::Context &context, const fs::path &path)
+{
+    auto document = xnb::open(context, path);
+    if (!document) {
+        return failure(document.error());
+    }
+
+    auto header = xnb::read_header(*document);
+    if (!header) {
+        return failure(header.error());
+    }
+    if (auto decompressed = xnb::decompress(context, *document);
+        !decompressed) {
+        return failure(decompressed.error());
+    }
+    auto asset = xnb::decode(*document);
+    if (!asset) {
+        return failure(asset.error());
+    }
+
+    std::string reply = "ok\t";
+    reply += header->target;
+    reply += "\t" + std::to_string(header->version);
+    reply += header->hidef ? "\thidef" : "\treach";
+    reply += header->compressed ? "\tcompressed" : "\tuncompressed";
+    reply += "\t" + std::to_string(header->file_size);
+    reply += "\t" + std::to_string(header->content_size);
+    reply += "\t";
+    reply += readers::type_name((*asset)->type());
+
+    xnb::recycle(context, std::move(*document));
+    return reply;
+}
+
+std::string extract(xnb::Context &context, const fs::path &path,
+                    const fs::path &stem)
+{
+    auto document = xnb::load(context, path);
+    if (!document) {
+        return failure(document.error());
+    }
+
+    auto exported = xnb::export_to(context, *document, stem);
+    xnb::recycle(context, std::move(*document));
+    if (!exported) {
+        return failure(exported.error());
+    }
+    return "ok\t" + stem.string();
+}
+
+std::string handle(Server &server, std::string_view line)
+{
+    auto fields = split(line);
+
+    if (fields[0] == "probe" && fields.size() == 2) {
+        return probe(server.context, fs::path(fields[1]));
+    }
+    if (fields[0] == "extract" && fields.size() == 3) {
+        return extract(server.context, fs::path(fields[1]),
+                       fs::path(fields[2]));
+    }
+    if (fields[0] == "shutdown" && fields.size() == 1) {
+        // accept() fails once the listener is shut down, ending the loop
+        // in serve().
+        server.stopping = true;
+        ::shutdown(server.listener, SHUT_RDWR);
+        return "ok";
+    }
+    return "error\tunknown request";
+}
+
+// NOTE: Runs on a connection's own thread, where an exception escaping
+// would end the whole server.
+std::string answer(Server &server, std::string_view line)
+{
+    try {
+        return handle(server, line);
+    } catch (const std::exception &e) {
+        return std::string("error\t") + e.what();
+    } catch (...) {
+        return "error\tunknown failure";
+    }
+}
+
+bool send_all(int fd, std::string_view text)
+{
+    while (!text.empty()) {
+        ssize_t sent = ::send(fd, text.data(), text.size(), 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        text.remove_prefix(sent);
+    }
+    return true;
+}
+
+void session(Server &server, int fd)
+{
+    std::string pending;
+    char chunk[4096];
+
+    while (!server.stopping) {
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(chunk, received);
+
+        size_t start = 0;
+        size_t end;
+        bool ok = true;
+        while (ok && (end = pending.find('\n', start)) != pending.npos) {
+            std::string_view line(pending.data() + start, end - start);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            start = end + 1;
+
+            if (!line.empty()) {
+                ok = send_all(fd, answer(server, line) + "\n");
+            }
+        }
+        pending.erase(0, start);
+
+        if (ok && pending.size() > MAX_LINE) {
+            send_all(fd, "error\trequest too long\n");
+            break;
+        }
+
+        if (!ok) {
+            break;
+        }
+    }
+
+    // Closed under the lock, so the number can't be handed out again by
+    // accept() while it is still in sessions.
+    std::lock_guard lock(server.mutex);
+    server.sessions.erase(fd);
+    ::close(fd);
+    server.done.notify_all();
+}
+/*
+ * Whether the path is free to bind. A socket left behind by a server that
+ * didn't shut down cleanly would keep the bind from working, so one that
+ * refuses connections is removed. Anything else at the path is left alone,
+ * be it a live server or a file that isn't a socket.
+ */
+bool claim(const std::string &name, const sockaddr_un &address)
+{
+    struct stat status;
+    if (::lstat(name.c_str(), &status) < 0) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        WARN("Can't look at ", name, ": ", std::strerror(errno));
+        return false;
+    }
+    if (!S_ISSOCK(status.st_mode)) {
+        WARN("Not replacing ", name, ", which isn't a socket");
+        return false;
+    }
+
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        WARN("Can't create a socket: ", std::strerror(errno));
+        return false;
+    }
+    int connected = ::connect(probe, (sockaddr *)&address, sizeof(address));
+    int error = errno;
+    ::close(probe);
+
+    if (connected == 0) {
+        WARN("A server is already listening on ", name);
+        return false;
+    }
+    if (error != ECONNREFUSED) {
+        WARN("Can't tell if ", name, " is in use: ", std::strerror(error));
+        return false;
+    }
+    if (::unlink(name.c_str()) < 0 && errno != ENOENT) {
+        WARN("Can't remove ", name, ": ", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int serve(xnb::Context &context, const fs::path &socket)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    auto name = socket.string();
+    if (name.size() >= sizeof(address.sun_path)) {
+        WARN("Socket path is too long: ", name);
+        return 1;
+    }
+    std::memcpy(address.sun_path, name.c_str(), name.size() + 1);
+
+    // Clients going away mid reply would end the whole server otherwise.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (!claim(name, address)) {
+        return 1;
+    }
+
+    Server server{context};
+    server.listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server.listener < 0) {
+        WARN("Can't create a socket: ", std::strerror(errno));
+        return 1;
+    }
+
+    if (::bind(server.listener, (sockaddr *)&address, sizeof(address)) < 0 ||
+        ::listen(server.listener, SOMAXCONN) < 0) {
+        WARN("Can't listen on ", name, ": ", std::strerror(errno));
+        ::close(server.listener);
+        return 1;
+    }
+
+    INFO("Listening on ", name);
+
+    while (!server.stopping) {
+        int fd = ::accept(server.listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+
+        std::lock_guard lock(server.mutex);
+        server.sessions.insert(fd);
+        std::thread(session, std::ref(server), fd).detach();
+    }
+
+    // Requests already running are finished, then idle connections are
+    // ended and waited on.
+    {
+        std::unique_lock lock(server.mutex);
+        for (int fd : server.sessions) {
+            ::shutdown(fd, SHUT_RD);
+        }
+        server.done.wait(lock, [&] { return server.sessions.empty(); });
+    }
+
+    ::close(server.listener);
+    ::unlink(name.c_str());
+    return server.stopping ? 0 : 1;
+}
+#endif
+} // namespace server
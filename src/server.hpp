@@ -0,0 +1,33 @@
+#pragma once
+
+#include "libxnb.hpp"
+
+#include <filesystem>
+
+/*
+ * Extraction as a long running service, so a build that goes through
+ * thousands of assets pays for process start up, allocation and LZX
+ * state set up once rather than per asset.
+ *
+ * Clients connect to a Unix domain socket and send requests as lines of
+ * tab separated fields, each answered by a line in turn:
+ *
+ *   probe <path>           ok <target> <version> <hidef> <compressed>
+ *                             <file size> <content size> <asset type>
+ *   extract <path> <stem>  ok <stem>
+ *   shutdown               ok
+ *
+ * A request that fails is answered with "error <message>". Outputs are
+ * named after the stem as on the command line, and written with the
+ * context's export options. A connection may send any number of
+ * requests, and several connections are served at once. One that sends
+ * a line over 64 KiB is answered with an error and closed.
+ *
+ * The server won't start over anything at the socket path but a socket
+ * left behind by one that is no longer running.
+ */
+namespace server
+{
+// Serves until a shutdown request. Returns the exit code.
+int serve(xnb::Context &context, const std::filesystem::path &socket);
+} // namespace server
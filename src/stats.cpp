@@ -0,0 +1,277 @@
+#include "stats.hpp"
+
+#include "trace.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace stats
+{
+const char *PHASE_NAMES[PHASE_COUNT] = {"load", "header", "decompress",
+                                        "parse", "export"};
+
+const char *COUNTER_NAMES[COUNTER_COUNT] = {
+    "bytes_in",       "bytes_out",           "frames",   "verbatim_blocks",
+    "aligned_blocks", "uncompressed_blocks", "literals", "matches"};
+
+namespace
+{
+const char *TREE_NAMES[] = {"pretree", "main", "length", "aligned"};
+const char *BLOCK_NAMES[] = {"", "verbatim", "aligned", "uncompressed"};
+
+// Match lengths up to 8 are told apart by the main tree alone, longer
+// ones need a symbol from the length tree as well.
+const unsigned LENGTH_BUCKETS[][2] = {
+    {2, 2},   {3, 3},   {4, 4},   {5, 5},    {6, 6},     {7, 7},
+    {8, 8},   {9, 16},  {17, 32}, {33, 64},  {65, 128},  {129, 257}};
+
+double percent(uint64_t part, uint64_t whole)
+{
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+void write_lzx_text(std::FILE *out, const LZXdetail &lzx,
+                    uint64_t matches)
+{
+    for (int i = 1; i < 4; ++i) {
+        std::fprintf(out, "  %-20s %12llu bytes\n", BLOCK_NAMES[i],
+                     lzx.block_bytes[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        std::fprintf(out, "  %-20s %12llu symbols, %5.1f%% long codes\n",
+                     TREE_NAMES[i], lzx.symbols[i],
+                     percent(lzx.long_codes[i], lzx.symbols[i]));
+    }
+    for (int i = 0; i < 3; ++i) {
+        std::fprintf(out, "  R%d repeats           %12llu %5.1f%%\n", i,
+                     lzx.repeats[i], percent(lzx.repeats[i], matches));
+    }
+
+    std::fprintf(out, "  match lengths\n");
+    for (auto &bucket : LENGTH_BUCKETS) {
+        unsigned long long count = 0;
+        for (unsigned length = bucket[0]; length <= bucket[1]; ++length) {
+            count += lzx.lengths[length];
+        }
+        std::fprintf(out, "    %3u-%-14u %12llu %5.1f%%\n", bucket[0],
+                     bucket[1], count, percent(count, matches));
+    }
+
+    std::fprintf(out, "  match offsets\n");
+    for (int bits = 1; bits < 32; ++bits) {
+        if (lzx.offsets[bits]) {
+            std::fprintf(out, "    %7u-%-10u %12llu %5.1f%%\n",
+                         1u << (bits - 1), (1u << bits) - 1,
+                         lzx.offsets[bits],
+                         percent(lzx.offsets[bits], matches));
+        }
+    }
+}
+
+void emit_lzx(Emitter &out, const LZXdetail &lzx)
+{
+    out.key("lzx");
+    out.begin_object();
+
+    out.key("block_bytes");
+    out.begin_object();
+    for (int i = 1; i < 4; ++i) {
+        out.key(BLOCK_NAMES[i]);
+        out.integer(uint64_t(lzx.block_bytes[i]));
+    }
+    out.end_object();
+
+    out.key("symbols");
+    out.begin_object();
+    for (int i = 0; i < 4; ++i) {
+        out.key(TREE_NAMES[i]);
+        out.integer(uint64_t(lzx.symbols[i]));
+    }
+    out.end_object();
+
+    out.key("long_codes");
+    out.begin_object();
+    for (int i = 0; i < 4; ++i) {
+        out.key(TREE_NAMES[i]);
+        out.integer(uint64_t(lzx.long_codes[i]));
+    }
+    out.end_object();
+
+    out.key("repeats");
+    out.begin_array();
+    for (auto count : lzx.repeats) {
+        out.integer(uint64_t(count));
+    }
+    out.end_array();
+
+    // Keyed by length and offset width, leaving out the empty ones.
+    out.key("lengths");
+    out.begin_object();
+    for (int length = 2; length < 258; ++length) {
+        if (lzx.lengths[length]) {
+            out.key(std::to_string(length));
+            out.integer(uint64_t(lzx.lengths[length]));
+        }
+    }
+    out.end_object();
+
+    out.key("offset_bits");
+    out.begin_object();
+    for (int bits = 1; bits < 32; ++bits) {
+        if (lzx.offsets[bits]) {
+            out.key(std::to_string(bits));
+            out.integer(uint64_t(lzx.offsets[bits]));
+        }
+    }
+    out.end_object();
+
+    out.end_object();
+}
+
+Record total(const std::vector<File> &files)
+{
+    Record sum;
+    for (auto &file : files) {
+        sum.add(file.record);
+    }
+    return sum;
+}
+
+void emit_record(Emitter &out, const Record &record)
+{
+    out.key("seconds");
+    out.begin_object();
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        out.key(PHASE_NAMES[i]);
+        out.real(record.seconds[i]);
+    }
+    out.end_object();
+
+    out.key("counters");
+    out.begin_object();
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        out.key(COUNTER_NAMES[i]);
+        out.integer(record.counts[i]);
+    }
+    out.end_object();
+
+    if (record.detailed) {
+        emit_lzx(out, record.lzx);
+    }
+}
+} // namespace
+
+void Record::add(const Record &other)
+{
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        seconds[i] += other.seconds[i];
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        counts[i] += other.counts[i];
+    }
+
+    if (!other.detailed) {
+        return;
+    }
+    detailed = true;
+
+    auto add_all = [](auto &to, auto &from) {
+        for (size_t i = 0; i < std::size(to); ++i) {
+            to[i] += from[i];
+        }
+    };
+    add_all(lzx.block_bytes, other.lzx.block_bytes);
+    add_all(lzx.symbols, other.lzx.symbols);
+    add_all(lzx.long_codes, other.lzx.long_codes);
+    add_all(lzx.repeats, other.lzx.repeats);
+    add_all(lzx.lengths, other.lzx.lengths);
+    add_all(lzx.offsets, other.lzx.offsets);
+}
+
+Timer::Timer(Record *record, Phase phase) : record(record), phase(phase)
+{
+    if (record || trace::enabled()) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+Timer::~Timer()
+{
+    if (!record && !trace::enabled()) {
+        return;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    if (record) {
+        std::chrono::duration<double> elapsed = end - start;
+        record->seconds[phase] += elapsed.count();
+    }
+    trace::record(PHASE_NAMES[phase], start, end);
+}
+
+// NOTE: Phase times are summed over all threads, so with more than one
+// they add up to more than the wall clock time.
+void write_text(std::FILE *out, const std::vector<File> &files,
+                double wall_seconds)
+{
+    Record sum = total(files);
+    double phases = 0;
+    for (double seconds : sum.seconds) {
+        phases += seconds;
+    }
+
+    size_t failed = 0;
+    for (auto &file : files) {
+        failed += !file.ok;
+    }
+
+    std::fprintf(out, "%zu files, %zu failed, %.3f s\n", files.size(),
+                 failed, wall_seconds);
+
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        std::fprintf(out, "  %-20s %10.3f s %5.1f%%\n", PHASE_NAMES[i],
+                     sum.seconds[i],
+                     phases > 0 ? 100 * sum.seconds[i] / phases : 0.0);
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        std::fprintf(out, "  %-20s %12llu\n", COUNTER_NAMES[i],
+                     (unsigned long long)sum.counts[i]);
+    }
+
+    if (sum.detailed) {
+        write_lzx_text(out, sum.lzx, sum.counts[Matches]);
+    }
+}
+
+void write_json(Emitter &out, const std::vector<File> &files,
+                double wall_seconds)
+{
+    out.begin_object();
+    out.key("wall_seconds");
+    out.real(wall_seconds);
+
+    out.key("total");
+    out.begin_object();
+    emit_record(out, total(files));
+    out.end_object();
+
+    out.key("files");
+    out.begin_array();
+    for (auto &file : files) {
+        out.begin_object();
+        out.key("path");
+        out.string(file.path);
+        out.key("ok");
+        out.boolean(file.ok);
+        emit_record(out, file.record);
+        out.end_object();
+    }
+    out.end_array();
+
+    out.end_object();
+}
+} // namespace stats
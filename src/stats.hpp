@@ -0,0 +1,81 @@
+#pragma once
+
+#include "emitter.hpp"
+#include "lzx.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace stats
+{
+// The steps a file goes through, in order.
+enum Phase
+{
+    Load,
+    Header,
+    Decompress,
+    Parse,
+    Export,
+    PHASE_COUNT
+};
+
+enum Counter
+{
+    BytesIn,  // size of the XNB
+    BytesOut, // size of its contents, once decompressed
+    Frames,
+    VerbatimBlocks,
+    AlignedBlocks,
+    UncompressedBlocks,
+    Literals,
+    Matches,
+    COUNTER_COUNT
+};
+
+extern const char *PHASE_NAMES[PHASE_COUNT];
+extern const char *COUNTER_NAMES[COUNTER_COUNT];
+
+// Where the time for one file went, or for a batch of them added up.
+struct Record
+{
+    double seconds[PHASE_COUNT] = {};
+    uint64_t counts[COUNTER_COUNT] = {};
+
+    // Filled in only by a decoder built with XNB_LZX_STATS.
+    bool detailed = false;
+    LZXdetail lzx = {};
+
+    void add(const Record &other);
+};
+
+// Adds the time until the end of the scope to a phase, and records it as
+// a span when tracing. Does nothing without a record or a trace, so it
+// can stay in place when both are off.
+struct Timer
+{
+    Record *record;
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+
+    Timer(Record *record, Phase phase);
+    ~Timer();
+};
+
+struct File
+{
+    std::string path;
+    bool ok = false;
+    Record record;
+};
+
+// Writes the totals as a table, for reading at the end of a run.
+void write_text(std::FILE *out, const std::vector<File> &files,
+                double wall_seconds);
+
+// Writes every file and the totals as JSON.
+void write_json(Emitter &out, const std::vector<File> &files,
+                double wall_seconds);
+} // namespace stats
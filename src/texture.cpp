@@ -0,0 +1,210 @@
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace texture
+{
+namespace
+{
+uint16_t u16(const uint8_t *in) { return in[0] | (in[1] << 8); }
+
+// Widens an n bit channel to 8 bits, repeating the top bits in the gap so
+// that the maximum maps to 255.
+uint8_t expand(unsigned value, int bits)
+{
+    value <<= 8 - bits;
+    return uint8_t(value | (value >> bits));
+}
+
+void decode_pixels(int format, const uint8_t *in, size_t count,
+                   uint8_t *out)
+{
+    for (size_t i = 0; i < count; ++i, out += 4) {
+        uint16_t v = format == Alpha8 ? 0 : u16(in + i * 2);
+
+        switch (format) {
+        case Bgr565:
+            out[0] = expand(v >> 11, 5);
+            out[1] = expand((v >> 5) & 0x3F, 6);
+            out[2] = expand(v & 0x1F, 5);
+            out[3] = 255;
+            break;
+        case Bgra5551:
+            out[0] = expand((v >> 10) & 0x1F, 5);
+            out[1] = expand((v >> 5) & 0x1F, 5);
+            out[2] = expand(v & 0x1F, 5);
+            out[3] = v & 0x8000 ? 255 : 0;
+            break;
+        case Bgra4444:
+            out[0] = expand((v >> 8) & 0xF, 4);
+            out[1] = expand((v >> 4) & 0xF, 4);
+            out[2] = expand(v & 0xF, 4);
+            out[3] = expand(v >> 12, 4);
+            break;
+        case Alpha8:
+            out[0] = out[1] = out[2] = 0;
+            out[3] = in[i];
+            break;
+        }
+    }
+}
+
+/*
+ * The colour half of a DXT block: two 565 endpoints and a 2 bit index per
+ * pixel. DXT1 blocks whose first endpoint isn't the greater one have only
+ * one colour in between, and index 3 is transparent black.
+ */
+void decode_colors(const uint8_t *block, bool dxt1, uint8_t out[16][4])
+{
+    uint16_t c0 = u16(block);
+    uint16_t c1 = u16(block + 2);
+
+    uint8_t palette[4][4];
+    for (int i = 0; i < 2; ++i) {
+        uint16_t c = i ? c1 : c0;
+        palette[i][0] = expand(c >> 11, 5);
+        palette[i][1] = expand((c >> 5) & 0x3F, 6);
+        palette[i][2] = expand(c & 0x1F, 5);
+        palette[i][3] = 255;
+    }
+
+    for (int ch = 0; ch < 3; ++ch) {
+        int a = palette[0][ch];
+        int b = palette[1][ch];
+        if (!dxt1 || c0 > c1) {
+            palette[2][ch] = uint8_t((2 * a + b) / 3);
+            palette[3][ch] = uint8_t((a + 2 * b) / 3);
+        } else {
+            palette[2][ch] = uint8_t((a + b) / 2);
+            palette[3][ch] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = dxt1 && c0 <= c1 ? 0 : 255;
+
+    for (int i = 0; i < 16; ++i) {
+        int index = (block[4 + i / 4] >> (2 * (i % 4))) & 3;
+        std::memcpy(out[i], palette[index], 4);
+    }
+}
+
+// Two 8 bit endpoints and a 3 bit index per pixel. Like DXT1 colours, the
+// endpoint order picks between two palettes.
+void decode_alpha(const uint8_t *block, uint8_t out[16][4])
+{
+    int a0 = block[0];
+    int a1 = block[1];
+
+    uint8_t palette[8] = {uint8_t(a0), uint8_t(a1)};
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = uint8_t(((7 - i) * a0 + i * a1) / 7);
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1] = uint8_t(((5 - i) * a0 + i * a1) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= uint64_t(block[2 + i]) << (8 * i);
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        out[i][3] = palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+void decode_blocks(int format, const uint8_t *in, int width, int height,
+                   uint8_t *rgba)
+{
+    size_t block_size = unit_size(format);
+    int blocks_x = (width + 3) / 4;
+    int blocks_y = (height + 3) / 4;
+
+    for (int by = 0; by < blocks_y; ++by) {
+        for (int bx = 0; bx < blocks_x; ++bx, in += block_size) {
+            uint8_t pixels[16][4];
+
+            if (format == Dxt1) {
+                decode_colors(in, true, pixels);
+            } else {
+                decode_colors(in + 8, false, pixels);
+                if (format == Dxt3) {
+                    for (int i = 0; i < 16; ++i) {
+                        pixels[i][3] =
+                            expand((in[i / 2] >> (4 * (i % 2))) & 0xF, 4);
+                    }
+                } else {
+                    decode_alpha(in, pixels);
+                }
+            }
+
+            // Blocks along the right and bottom edges may hang over.
+            int columns = std::min(4, width - bx * 4);
+            int rows = std::min(4, height - by * 4);
+            for (int y = 0; y < rows; ++y) {
+                uint8_t *row =
+                    rgba + (size_t(by * 4 + y) * width + bx * 4) * 4;
+                std::memcpy(row, pixels[y * 4], columns * 4);
+            }
+        }
+    }
+}
+} // namespace
+
+bool supported(int format) { return unit_size(format) != 0; }
+
+bool compressed(int format)
+{
+    return format == Dxt1 || format == Dxt3 || format == Dxt5;
+}
+
+size_t unit_size(int format)
+{
+    switch (format) {
+    case Color:
+        return 4;
+    case Bgr565:
+    case Bgra5551:
+    case Bgra4444:
+        return 2;
+    case Alpha8:
+        return 1;
+    case Dxt1:
+        return 8;
+    case Dxt3:
+    case Dxt5:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+size_t image_size(int format, int width, int height)
+{
+    if (compressed(format)) {
+        return size_t((width + 3) / 4) * ((height + 3) / 4) *
+               unit_size(format);
+    }
+    return size_t(width) * height * unit_size(format);
+}
+
+void decode(int format, std::span<const uint8_t> in, int width, int height,
+            uint8_t *rgba)
+{
+    if (format == Color) {
+        std::memcpy(rgba, in.data(), size_t(width) * height * 4);
+    } else if (compressed(format)) {
+        decode_blocks(format, in.data(), width, height, rgba);
+    } else {
+        decode_pixels(format, in.data(), size_t(width) * height, rgba);
+    }
+}
+} // namespace texture
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace texture
+{
+// XNA 4 SurfaceFormat values, for the formats that can be decoded.
+enum SurfaceFormat
+{
+    Color = 0,
+    Bgr565 = 1,
+    Bgra5551 = 2,
+    Bgra4444 = 3,
+    Dxt1 = 4,
+    Dxt3 = 5,
+    Dxt5 = 6,
+    Alpha8 = 12
+};
+
+bool supported(int format);
+
+bool compressed(int format);
+
+// Bytes per pixel, or per 4x4 block for compressed formats.
+size_t unit_size(int format);
+
+// Bytes taken by one image, 0 if the format isn't supported.
+size_t image_size(int format, int width, int height);
+
+// Decodes one image to RGBA with rows of 4 * width bytes. The input must
+// hold at least image_size bytes.
+void decode(int format, std::span<const uint8_t> in, int width, int height,
+            uint8_t *rgba);
+} // namespace texture
@@ -0,0 +1,190 @@
+#include "trace.hpp"
+
+#include "emitter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trace
+{
+namespace
+{
+// Spans kept per thread, a few MB in all.
+const size_t RING_SIZE = 1 << 16;
+const uint32_t NO_FILE = UINT32_MAX;
+
+struct Event
+{
+    const char *name;
+    uint32_t file;
+    int64_t start;    // ns since the trace was enabled
+    int64_t duration; // ns
+};
+
+struct Ring
+{
+    std::unique_ptr<Event[]> events{new Event[RING_SIZE]};
+
+    // Written by the owning thread only. Release stores publish the
+    // events before it to the writer.
+    std::atomic<uint64_t> head{0};
+
+    uint32_t thread;
+    Ring *next = nullptr;
+};
+
+std::atomic<bool> active{false};
+Clock::time_point origin;
+
+// Every thread's ring, pushed on the front as threads first record.
+// Rings are never freed, threads may be recording until exit.
+std::atomic<Ring *> rings{nullptr};
+std::atomic<uint32_t> thread_count{0};
+
+thread_local Ring *local = nullptr;
+thread_local uint32_t current_file = NO_FILE;
+
+Ring &ring()
+{
+    if (!local) {
+        local = new Ring;
+        local->thread = thread_count.fetch_add(1);
+        local->next = rings.load(std::memory_order_relaxed);
+        while (!rings.compare_exchange_weak(local->next, local,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+    return *local;
+}
+
+int64_t since_origin(Clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - origin)
+        .count();
+}
+} // namespace
+
+void enable()
+{
+    origin = Clock::now();
+    active.store(true, std::memory_order_release);
+}
+
+bool enabled() { return active.load(std::memory_order_relaxed); }
+
+FileScope::FileScope(uint32_t file) : previous(current_file)
+{
+    current_file = file;
+}
+
+FileScope::~FileScope() { current_file = previous; }
+
+void record(const char *name, Clock::time_point start, Clock::time_point end)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    auto &out = ring();
+    uint64_t head = out.head.load(std::memory_order_relaxed);
+    int64_t at = since_origin(start);
+    out.events[head % RING_SIZE] = {name, current_file, at,
+                                    since_origin(end) - at};
+    out.head.store(head + 1, std::memory_order_release);
+}
+
+Span::Span(const char *name) : name(name)
+{
+    if (enabled()) {
+        start = Clock::now();
+    }
+}
+
+Span::~Span()
+{
+    if (enabled()) {
+        record(name, start, Clock::now());
+    }
+}
+
+// NOTE: Chrome wants times in microseconds. Complete events ("X") carry
+// their own duration, so spans don't have to be paired up.
+bool write(const std::filesystem::path &path,
+           const std::vector<std::string> &files)
+{
+    std::FILE *file = std::fopen(path.string().c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    JsonEmitter out(file);
+    out.begin_object();
+    out.key("displayTimeUnit");
+    out.string("ms");
+    out.key("traceEvents");
+    out.begin_array();
+
+    for (Ring *ring = rings.load(std::memory_order_acquire); ring;
+         ring = ring->next) {
+        out.begin_object();
+        out.key("name");
+        out.string("thread_name");
+        out.key("ph");
+        out.string("M");
+        out.key("pid");
+        out.integer(int64_t(1));
+        out.key("tid");
+        out.integer(int64_t(ring->thread));
+        out.key("args");
+        out.begin_object();
+        out.key("name");
+        out.string("thread " + std::to_string(ring->thread));
+        out.end_object();
+        out.end_object();
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+
+        for (uint64_t i = first; i < head; ++i) {
+            auto &event = ring->events[i % RING_SIZE];
+
+            out.begin_object();
+            out.key("name");
+            out.string(event.name);
+            out.key("cat");
+            out.string("xnb");
+            out.key("ph");
+            out.string("X");
+            out.key("ts");
+            out.real(event.start / 1e3);
+            out.key("dur");
+            out.real(event.duration / 1e3);
+            out.key("pid");
+            out.integer(int64_t(1));
+            out.key("tid");
+            out.integer(int64_t(ring->thread));
+
+            if (event.file < files.size()) {
+                out.key("args");
+                out.begin_object();
+                out.key("file");
+                out.string(files[event.file]);
+                out.end_object();
+            }
+            out.end_object();
+        }
+    }
+
+    out.end_array();
+    out.end_object();
+
+    bool ok = out.finish();
+    return std::fclose(file) == 0 && ok;
+}
+} // namespace trace
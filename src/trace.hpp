@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*
+ * Records spans of work per thread, to be written out as Chrome trace
+ * event JSON and opened in chrome://tracing or Perfetto. Each thread
+ * appends to a ring buffer of its own, so recording takes no locks and
+ * threads never wait on each other. When a ring fills up the oldest
+ * spans are overwritten.
+ */
+namespace trace
+{
+using Clock = std::chrono::steady_clock;
+
+// Spans are only recorded once this is called.
+void enable();
+bool enabled();
+
+// Marks the spans this thread records from now on as belonging to the
+// file with this index, until the scope ends.
+struct FileScope
+{
+    uint32_t previous;
+
+    explicit FileScope(uint32_t file);
+    ~FileScope();
+};
+
+// name must outlive the trace, a string literal for instance.
+void record(const char *name, Clock::time_point start, Clock::time_point end);
+
+// Records the time until the end of the scope.
+struct Span
+{
+    const char *name;
+    Clock::time_point start;
+
+    explicit Span(const char *name);
+    ~Span();
+};
+
+// Writes everything recorded so far, naming files by their index into
+// files. Must not race with threads still recording.
+bool write(const std::filesystem::path &path,
+           const std::vector<std::string> &files);
+} // namespace trace
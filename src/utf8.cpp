@@ -0,0 +1,372 @@
+#include "utf8.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#define UTF8_SSSE3 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define UTF8_NEON 1
+#endif
+
+namespace utf8
+{
+namespace
+{
+// Length of the well formed sequence at the start of text, 0 if there
+// isn't one.
+size_t sequence_length(const uint8_t *text, size_t size)
+{
+    uint8_t lead = text[0];
+    if (lead < 0x80) {
+        return 1;
+    }
+
+    size_t length;
+    uint8_t low = 0x80;
+    uint8_t high = 0xBF;
+
+    if (lead < 0xC2) {
+        return 0;
+    } else if (lead < 0xE0) {
+        length = 2;
+    } else if (lead < 0xF0) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead < 0xF5) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+
+    if (size < length || text[1] < low || text[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if ((text[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+bool valid_scalar(const uint8_t *text, size_t size)
+{
+    size_t i = 0;
+
+    while (i < size) {
+        // Eight ASCII bytes at a time.
+        uint64_t word;
+        if (i + 8 <= size) {
+            std::memcpy(&word, text + i, 8);
+            if ((word & 0x8080808080808080) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+
+        size_t length = sequence_length(text + i, size - i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+
+    return true;
+}
+
+/*
+ * The lookup algorithm from Keiser and Lemire, "Validating UTF-8 In Less
+ * Than One Instruction Per Byte". Every error shows up in the high and
+ * low nibble of a byte together with the high nibble of the next one, so
+ * three table lookups classify all pairs of bytes in a block at once.
+ * Sequences of three and four bytes additionally need their third and
+ * fourth bytes to be continuations, which is checked against the bytes
+ * two and three back.
+ */
+const uint8_t TOO_SHORT = 1 << 0;
+const uint8_t TOO_LONG = 1 << 1;
+const uint8_t OVERLONG_3 = 1 << 2;
+const uint8_t TOO_LARGE = 1 << 3;
+const uint8_t SURROGATE = 1 << 4;
+const uint8_t OVERLONG_2 = 1 << 5;
+const uint8_t TOO_LARGE_1000 = 1 << 6;
+const uint8_t OVERLONG_4 = 1 << 6;
+const uint8_t TWO_CONTS = 1 << 7;
+const uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+// Indexed by the high nibble of the first byte.
+const uint8_t BYTE_1_HIGH[16] = {
+    TOO_LONG,
+    TOO_LONG,
+    TOO_LONG,
+    TOO_LONG,
+    TOO_LONG,
+    TOO_LONG,
+    TOO_LONG,
+    TOO_LONG,
+    TWO_CONTS,
+    TWO_CONTS,
+    TWO_CONTS,
+    TWO_CONTS,
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+// Indexed by the low nibble of the first byte.
+const uint8_t BYTE_1_LOW[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+// Indexed by the high nibble of the second byte.
+const uint8_t BYTE_2_HIGH[16] = {
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 |
+        OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+    TOO_SHORT,
+};
+
+// Bytes above these at the end of a block start a sequence that carries
+// on into the next one.
+const uint8_t INCOMPLETE[16] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                0xFF, 0xEF, 0xDF, 0xBF};
+
+#if defined(UTF8_SSSE3)
+__attribute__((target("ssse3"))) bool valid_ssse3(const uint8_t *text,
+                                                  size_t size)
+{
+    const __m128i byte_1_high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(BYTE_1_HIGH));
+    const __m128i byte_1_low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(BYTE_1_LOW));
+    const __m128i byte_2_high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(BYTE_2_HIGH));
+    const __m128i incomplete_max =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(INCOMPLETE));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+
+    __m128i previous = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+
+    for (size_t i = 0; i < size; i += 16) {
+        __m128i input;
+        if (i + 16 <= size) {
+            input =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        } else {
+            // The tail is padded with ASCII, which can't add errors.
+            uint8_t tail[16] = {};
+            std::memcpy(tail, text + i, size - i);
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail));
+        }
+
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, incomplete);
+            previous = input;
+            incomplete = _mm_setzero_si128();
+            continue;
+        }
+
+        __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+        __m128i special = _mm_and_si128(
+            _mm_and_si128(
+                _mm_shuffle_epi8(byte_1_high,
+                                 _mm_and_si128(_mm_srli_epi16(prev1, 4),
+                                               nibble)),
+                _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+            _mm_shuffle_epi8(byte_2_high,
+                             _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+        __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+        __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+        __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xDF)));
+        __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xEF)));
+        __m128i must_continue =
+            _mm_and_si128(_mm_cmpgt_epi8(_mm_or_si128(third, fourth),
+                                         _mm_setzero_si128()),
+                          _mm_set1_epi8(char(0x80)));
+
+        // NOTE: cmpgt is signed, but the saturated differences are small.
+        error = _mm_or_si128(error, _mm_xor_si128(must_continue, special));
+
+        previous = input;
+        incomplete = _mm_subs_epu8(input, incomplete_max);
+    }
+
+    error = _mm_or_si128(error, incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) ==
+           0xFFFF;
+}
+
+bool has_ssse3()
+{
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+#elif defined(UTF8_NEON)
+bool valid_neon(const uint8_t *text, size_t size)
+{
+    const uint8x16_t byte_1_high = vld1q_u8(BYTE_1_HIGH);
+    const uint8x16_t byte_1_low = vld1q_u8(BYTE_1_LOW);
+    const uint8x16_t byte_2_high = vld1q_u8(BYTE_2_HIGH);
+    const uint8x16_t incomplete_max = vld1q_u8(INCOMPLETE);
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+
+    uint8x16_t previous = vdupq_n_u8(0);
+    uint8x16_t incomplete = vdupq_n_u8(0);
+    uint8x16_t error = vdupq_n_u8(0);
+
+    for (size_t i = 0; i < size; i += 16) {
+        uint8x16_t input;
+        if (i + 16 <= size) {
+            input = vld1q_u8(text + i);
+        } else {
+            uint8_t tail[16] = {};
+            std::memcpy(tail, text + i, size - i);
+            input = vld1q_u8(tail);
+        }
+
+        if (vmaxvq_u8(input) < 0x80) {
+            error = vorrq_u8(error, incomplete);
+            previous = input;
+            incomplete = vdupq_n_u8(0);
+            continue;
+        }
+
+        uint8x16_t prev1 = vextq_u8(previous, input, 15);
+        uint8x16_t special = vandq_u8(
+            vandq_u8(vqtbl1q_u8(byte_1_high, vshrq_n_u8(prev1, 4)),
+                     vqtbl1q_u8(byte_1_low, vandq_u8(prev1, nibble))),
+            vqtbl1q_u8(byte_2_high, vshrq_n_u8(input, 4)));
+
+        uint8x16_t prev2 = vextq_u8(previous, input, 14);
+        uint8x16_t prev3 = vextq_u8(previous, input, 13);
+        uint8x16_t must_continue =
+            vandq_u8(vcgtq_u8(vorrq_u8(vqsubq_u8(prev2, vdupq_n_u8(0xDF)),
+                                       vqsubq_u8(prev3, vdupq_n_u8(0xEF))),
+                              vdupq_n_u8(0)),
+                     vdupq_n_u8(0x80));
+
+        error = vorrq_u8(error, veorq_u8(must_continue, special));
+
+        previous = input;
+        incomplete = vqsubq_u8(input, incomplete_max);
+    }
+
+    error = vorrq_u8(error, incomplete);
+    return vmaxvq_u8(error) == 0;
+}
+#endif
+
+// Skips the ASCII run at the start of text, sixteen bytes at a time.
+size_t ascii_prefix(const uint8_t *text, size_t size)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && text[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+} // namespace
+
+/*
+ * Most strings in game data are plain ASCII, which is skipped over first.
+ * Whatever is left goes through the vectorized validator where the CPU
+ * has one, or a byte by byte check otherwise.
+ */
+bool valid(std::string_view text)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(text.data());
+    size_t ascii = ascii_prefix(bytes, text.size());
+    if (ascii == text.size()) {
+        return true;
+    }
+
+    // NOTE: An ASCII byte can't be inside a sequence, so validation can
+    // start right after the run.
+    bytes += ascii;
+    size_t size = text.size() - ascii;
+
+#if defined(UTF8_SSSE3)
+    if (has_ssse3()) {
+        return valid_ssse3(bytes, size);
+    }
+#elif defined(UTF8_NEON)
+    return valid_neon(bytes, size);
+#endif
+
+    return valid_scalar(bytes, size);
+}
+
+void repair(std::string_view text, std::string &out)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(text.data());
+    size_t i = 0;
+
+    while (i < text.size()) {
+        size_t length = sequence_length(bytes + i, text.size() - i);
+        if (length == 0) {
+            out += "\xEF\xBF\xBD";
+            ++i;
+        } else {
+            out.append(text.data() + i, length);
+            i += length;
+        }
+    }
+}
+} // namespace utf8
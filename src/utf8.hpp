@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace utf8
+{
+// Whether text is well formed UTF-8: no stray continuation bytes, no
+// truncated or overlong sequences, no surrogates and nothing past
+// U+10FFFF.
+bool valid(std::string_view text);
+
+// Appends text to out with every byte that isn't part of a well formed
+// sequence replaced by U+FFFD.
+void repair(std::string_view text, std::string &out);
+} // namespace utf8
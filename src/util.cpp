@@ -0,0 +1,191 @@
+#include "util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logging
+{
+namespace
+{
+// A thread's buffer is handed over early once it grows past this, rather
+// than waiting for the next round.
+const size_t HIGH_WATER = 64 * 1024;
+const auto INTERVAL = std::chrono::milliseconds(50);
+
+const char *PREFIXES[] = {"[DEBUG] ", " [INFO] ", " [WARN] "};
+
+std::atomic<int> threshold{Debug};
+
+// Only its own thread appends to a buffer, and the writer only takes
+// the lock to swap the text out, so the lock is almost never contended.
+struct Buffer
+{
+    std::mutex lock;
+    std::string text;
+};
+
+struct Writer
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::thread thread;
+    bool stopping = false;
+
+    // What a buffer's text is swapped with, so both keep their storage.
+    std::string spare;
+
+    // Each thread that logs gets a buffer, until it exits.
+    Buffer *add()
+    {
+        std::lock_guard guard(lock);
+        if (!thread.joinable()) {
+            thread = std::thread([this] { run(); });
+        }
+        buffers.push_back(std::make_unique<Buffer>());
+        return buffers.back().get();
+    }
+
+    // Writes out what is left in the buffer of a thread that is exiting,
+    // and drops it.
+    void remove(Buffer *buffer)
+    {
+        std::lock_guard guard(lock);
+        write(*buffer);
+        std::fflush(stdout);
+        std::erase_if(buffers, [&](auto &kept) {
+            return kept.get() == buffer;
+        });
+    }
+
+    void run()
+    {
+        std::unique_lock guard(lock);
+        while (!stopping) {
+            wake.wait_for(guard, INTERVAL);
+            drain();
+        }
+    }
+
+    // Called with lock held. Returns whether there was anything to write.
+    bool write(Buffer &buffer)
+    {
+        {
+            std::lock_guard swap(buffer.lock);
+            spare.swap(buffer.text);
+        }
+        if (spare.empty()) {
+            return false;
+        }
+        std::fwrite(spare.data(), 1, spare.size(), stdout);
+        spare.clear();
+        return true;
+    }
+
+    // Called with lock held.
+    void drain()
+    {
+        bool wrote = false;
+        for (auto &buffer : buffers) {
+            wrote |= write(*buffer);
+        }
+
+        if (wrote) {
+            std::fflush(stdout);
+        }
+    }
+
+    ~Writer()
+    {
+        {
+            std::lock_guard guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        drain();
+    }
+};
+
+Writer writer;
+
+// NOTE: Threads come and go, one per connection in the server, so a
+// thread's buffer is handed back when it exits rather than kept until
+// the program does.
+struct Local
+{
+    Buffer *buffer = nullptr;
+
+    ~Local()
+    {
+        if (buffer) {
+            writer.remove(buffer);
+        }
+    }
+};
+
+thread_local Local local;
+thread_local std::ostringstream line;
+} // namespace
+
+void set_level(Level level) { threshold.store(level); }
+
+bool enabled(Level level)
+{
+    return level >= threshold.load(std::memory_order_relaxed);
+}
+
+std::ostream &begin()
+{
+    line.str({});
+    line.clear();
+    return line;
+}
+
+void commit(Level level)
+{
+    // NOTE: One write per line, so lines from different threads don't
+    // interleave.
+    if (level >= Warning) {
+        std::string text = PREFIXES[level];
+        text += line.view();
+        text += '\n';
+        std::fwrite(text.data(), 1, text.size(), stderr);
+        return;
+    }
+
+    if (!local.buffer) {
+        local.buffer = writer.add();
+    }
+
+    auto &buffer = *local.buffer;
+    bool full;
+    {
+        std::lock_guard guard(buffer.lock);
+        buffer.text += PREFIXES[level];
+        buffer.text += line.view();
+        buffer.text += '\n';
+        full = buffer.text.size() > HIGH_WATER;
+    }
+
+    if (full) {
+        writer.wake.notify_one();
+    }
+}
+
+void flush()
+{
+    std::lock_guard guard(writer.lock);
+    writer.drain();
+}
+} // namespace logging
@@ -1,26 +1,74 @@
 #pragma once
 
-#include <iostream>
+#include <ostream>
 
-#define INFO(...) std::cout, " [INFO] ", __VA_ARGS__, std::endl
+/*
+ * Leveled logging. A message is formatted into a buffer owned by the
+ * thread logging it, and a background thread writes the buffers out to
+ * stdout in batches, so threads never wait on the terminal or on each
+ * other. Lines from one thread stay in order, lines from different
+ * threads may not. Warnings are written to stderr as they are logged
+ * instead, so they stay out of anything written to stdout.
+ *
+ * Levels below XNB_LOG_LEVEL are compiled out along with their
+ * arguments. The debug build (XNA_LOG) keeps every level.
+ */
+namespace logging
+{
+enum Level
+{
+    Debug,
+    Info,
+    Warning,
+    Off
+};
+
+// Drops messages below level from now on, for instance to keep the log
+// out of a benchmark.
+void set_level(Level level);
+bool enabled(Level level);
+
+// The stream a message is formatted into, cleared for this thread.
+std::ostream &begin();
+// Queues what was formatted since begin() as one line.
+void commit(Level level);
+
+// Writes out everything logged so far, from every thread.
+void flush();
 
+template <typename... Args>
+void write(Level level, const Args &...args)
+{
+    if (!enabled(level)) {
+        return;
+    }
+    (begin() << ... << args);
+    commit(level);
+}
+} // namespace logging
+
+#ifndef XNB_LOG_LEVEL
 #ifdef XNA_LOG
-#define DEBUG(...) std::cout, "[DEBUG] ", __VA_ARGS__, std::endl
+#define XNB_LOG_LEVEL 0
 #else
-#define DEBUG(...)
+#define XNB_LOG_LEVEL 1
+#endif
 #endif
 
-template <typename T>
-std::ostream &operator,(std::ostream &out, const T &t)
-{
-    out << t;
-    return out;
-}
+#if XNB_LOG_LEVEL <= 0
+#define DEBUG(...) logging::write(logging::Debug, __VA_ARGS__)
+#else
+#define DEBUG(...) ((void)0)
+#endif
 
-// overloaded version to handle all those special std::endl and others...
-inline std::ostream &operator,(std::ostream &out,
-                        std::ostream &(*f)(std::ostream &))
-{
-    out << f;
-    return out;
-}
+#if XNB_LOG_LEVEL <= 1
+#define INFO(...) logging::write(logging::Info, __VA_ARGS__)
+#else
+#define INFO(...) ((void)0)
+#endif
+
+#if XNB_LOG_LEVEL <= 2
+#define WARN(...) logging::write(logging::Warning, __VA_ARGS__)
+#else
+#define WARN(...) ((void)0)
+#endif
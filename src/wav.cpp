@@ -0,0 +1,106 @@
+#include "wav.hpp"
+
+#include "io.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace wav
+{
+namespace
+{
+const size_t SAMPLE_RATE_OFFSET = 4;
+const size_t SMPL_SIZE = 36 + 24;
+
+struct Writer
+{
+    std::vector<uint8_t> bytes;
+
+    void tag(std::string_view tag)
+    {
+        bytes.insert(bytes.end(), tag.begin(), tag.end());
+    }
+
+    void u32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) {
+            bytes.push_back(uint8_t(value >> (8 * i)));
+        }
+    }
+};
+} // namespace
+
+/*
+ * The file is laid out as
+ *
+ * 	RIFF <size> WAVE
+ * 	fmt  <size> <WAVEFORMATEX>
+ * 	data <size> <samples> [pad]
+ * 	smpl <size> <sampler header> <loop>
+ *
+ * The samples are never copied: the chunks around them are built in small
+ * buffers and written out together with the sample data in one go.
+ */
+bool write(const std::filesystem::path &path, std::span<const uint8_t> format,
+           std::span<const uint8_t> data, Loop loop)
+{
+    if (format.size() < 16) {
+        return false;
+    }
+
+    bool padded = data.size() & 1;
+    bool looped = loop.length > 0;
+
+    size_t riff_size = 4 + (8 + format.size() + (format.size() & 1)) +
+                       (8 + data.size() + padded) +
+                       (looped ? 8 + SMPL_SIZE : 0);
+
+    Writer head;
+    head.tag("RIFF");
+    head.u32(riff_size);
+    head.tag("WAVE");
+    head.tag("fmt ");
+    head.u32(format.size());
+    head.bytes.insert(head.bytes.end(), format.begin(), format.end());
+    if (format.size() & 1) {
+        head.bytes.push_back(0);
+    }
+    head.tag("data");
+    head.u32(data.size());
+
+    Writer tail;
+    if (padded) {
+        tail.bytes.push_back(0);
+    }
+
+    if (looped) {
+        uint32_t sample_rate = 0;
+        for (int i = 3; i >= 0; --i) {
+            sample_rate = (sample_rate << 8) | format[SAMPLE_RATE_OFFSET + i];
+        }
+
+        tail.tag("smpl");
+        tail.u32(SMPL_SIZE);
+        tail.u32(0); // manufacturer
+        tail.u32(0); // product
+        tail.u32(sample_rate ? 1000000000 / sample_rate : 0); // period, ns
+        tail.u32(60); // MIDI unity note, middle C
+        tail.u32(0); // pitch fraction
+        tail.u32(0); // SMPTE format
+        tail.u32(0); // SMPTE offset
+        tail.u32(1); // loop count
+        tail.u32(0); // sampler data size
+
+        tail.u32(0); // cue point id
+        tail.u32(0); // forward loop
+        tail.u32(loop.start);
+        tail.u32(loop.start + loop.length - 1); // inclusive
+        tail.u32(0); // fraction
+        tail.u32(0); // play forever
+    }
+
+    return io::write_file(path, {head.bytes, data, tail.bytes});
+}
+} // namespace wav
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace wav
+{
+const uint16_t FORMAT_PCM = 1;
+const uint16_t FORMAT_ADPCM = 2;
+
+// Loop points in samples, as stored by SoundEffect. A length of 0 means
+// the sound doesn't loop.
+struct Loop
+{
+    uint32_t start = 0;
+    uint32_t length = 0;
+};
+
+// Writes a RIFF/WAVE file from a WAVEFORMATEX header and the sample data
+// it describes, with the loop as a smpl chunk.
+bool write(const std::filesystem::path &path, std::span<const uint8_t> format,
+           std::span<const uint8_t> data, Loop loop);
+} // namespace wav
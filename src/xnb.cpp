@@ -1,58 +1,128 @@
 #include "xnb.hpp"
 
+#include "io.hpp"
 #include "lzx.h"
-#include "readers/texture2d.hpp"
+#include "readers/registry.hpp"
 #include "util.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
-#include <format>
-#include <fstream>
-#include <iterator>
 #include <ostream>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-
 const uint8_t HIDEF_MASK = 0x1;
 const uint8_t COMPRESSED_LZX_MASK = 0x80;
 const uint8_t COMPRESSED_LZ4_MASK = 0x80;
 
 const size_t XNB_COMPRESSED_HEADER_SIZE = 14;
 
-Xnb::Xnb(std::string path)
+// Each frame of LZX data takes at least 3 bytes, its size and some data,
+// and gives at most 64K.
+const size_t LZX_MIN_FRAME_INPUT = 3;
+const size_t LZX_MAX_FRAME_SIZE = 0xFFFF;
+
+// A reader takes at least a byte for its name's length and 4 for its
+// version.
+const size_t MIN_READER_SIZE = 5;
+
+namespace
+{
+// An object running past the end of the buffer can't be read, like any
+// other that is corrupt.
+readers::ReaderPtr read_object(const readers::Manifest &manifest,
+                               Buffer &buffer)
+{
+    try {
+        return manifest.read_object(buffer);
+    } catch (const Buffer::Overrun &) {
+        DEBUG("Object overruns the file");
+        return nullptr;
+    }
+}
+} // namespace
+
+Xnb::Xnb(std::string path, stats::Record *stats) : stats(stats)
 {
-    std::ifstream instream(path, std::ios::in | std::ios::binary);
-    std::vector<uint8_t> out((std::istreambuf_iterator<char>(instream)),
-                             std::istreambuf_iterator<char>());
-    buffer = Buffer(out);
+    std::vector<uint8_t> out;
+    {
+        stats::Timer timer(stats, stats::Load);
+        io::read_file(path, out);
+    }
+
+    if (open(std::move(out)) && decompress()) {
+        read_content();
+    }
+}
+
+bool Xnb::open(std::vector<uint8_t> bytes)
+{
+    if (stats) {
+        stats->counts[stats::BytesIn] += bytes.size();
+    }
 
-    read_header();
+    buffer = Buffer(std::move(bytes));
 
+    {
+        stats::Timer timer(stats, stats::Header);
+        read_header();
+    }
+
+    return valid;
+}
+
+bool Xnb::decompress()
+{
     if (compressed) {
+        stats::Timer timer(stats, stats::Decompress);
         INFO("Data is compressed with LZX. Decompressing");
-        buffer = decompress_lzx();
+        if (!decompress_lzx()) {
+            return false;
+        }
         INFO("Data is uncompressed");
     }
 
+    if (stats) {
+        stats->counts[stats::BytesOut] += buffer.remaining();
+    }
+
+    return true;
+}
+
+bool Xnb::read_content()
+{
+    stats::Timer timer(stats, stats::Parse);
+
     reader_count = buffer.read_7_bit_int();
     INFO("Reader count: ", reader_count);
 
-    std::vector<readers::Reader *> reader_list(reader_count);
+    if (reader_count < 0 ||
+        size_t(reader_count) > buffer.remaining() / MIN_READER_SIZE) {
+        WARN("Reader count overruns the file");
+        return false;
+    }
 
-    // Get all the type readers.
+    // Get all the type readers. Unsupported ones still take up their slot
+    // so the indices below line up. The names are only needed to look up
+    // the cached readers, so they are viewed in place rather than copied.
     for (int i = 0; i < reader_count; ++i) {
-        std::string type = buffer.read_string();
+        auto type = buffer.read_string_view();
+        if (buffer.remaining() < 4) {
+            WARN("Reader table overruns the file");
+            return false;
+        }
         int version = buffer.read_i32();
         DEBUG("Reader: ", type);
 
-        if (type.starts_with(
-                "Microsoft.Xna.Framework.Content.Texture2DReader")) {
-            reader_list.push_back(new readers::Texture2DReader);
+        auto factory = readers::resolve_reader(type);
+        if (!factory) {
+            WARN("Unsupported reader: ", type);
         }
+        manifest.readers.push_back(factory);
+        reader_names.push_back(type);
     }
 
     shared_resource_count = buffer.read_7_bit_int();
@@ -61,32 +131,46 @@ Xnb::Xnb(std::string path)
     // XXX: This was a big pain. The content data is polymorphic, so in
     // order to determine what data lies first, a 7 bit int is used to
     // index into the list of readers constructed above. Then the
-    // respective reader is used to actually read the data. Hence no need
-    // for any hacky +1 issues.
+    // respective reader is used to actually read the data.
+    asset = read_object(manifest, buffer);
 
-    int read_index = buffer.read_7_bit_int();
-    DEBUG("Read index: ", read_index);
+    if (!asset) {
+        WARN("Could not read the primary asset");
+        return false;
+    }
 
-    auto reader = reader_list[read_index];
-    reader->read(buffer);
+    // Shared resources follow the primary asset. Anything referring to them
+    // holds an index into this table, so they are usable from here on.
+    // Each takes at least a byte for its type index.
+    if (shared_resource_count < 0 ||
+        size_t(shared_resource_count) > buffer.remaining()) {
+        WARN("Shared resource count overruns the file");
+        return true;
+    }
 
-    auto texture = (readers::Texture2DReader *)reader;
+    // NOTE: Once a resource can't be read, where the next one starts isn't
+    // known, so the rest are left out and resolve to null.
+    for (int i = 0; i < shared_resource_count; ++i) {
+        auto resource = read_object(manifest, buffer);
+        if (!resource) {
+            WARN("Could not read shared resource ", i);
+            break;
+        }
+        manifest.shared_resources->push_back(std::move(resource));
+    }
 
-    // Valid and working. Weird visual artificats are in the actual pixel
-    // data itself.
-    stbi_write_png("out.png", texture->width, texture->height, 4,
-                   texture->bytes.data(), 4 * texture->width);
+    return true;
 }
 
 void Xnb::read_header()
 {
-    if (buffer.read_raw_string(3) != "XNB") {
-        valid = false;
+    valid = false;
+
+    // The magic, the target, the version and the flags come first.
+    if (buffer.remaining() < 6 || buffer.read_raw_string(3) != "XNB") {
         return;
     }
 
-    INFO("File is valid XNB");
-
     target = static_cast<char>(buffer.read_byte());
     format_version = static_cast<int>(buffer.read_byte());
 
@@ -102,11 +186,20 @@ void Xnb::read_header()
         compression_type = CompressionType::LX4;
     }
 
+    // Then the size of the file, and the size of its contents once
+    // decompressed if they are compressed.
+    if (buffer.remaining() < (compressed ? 8 : 4)) {
+        return;
+    }
+
     filesize = buffer.read_u32();
 
     if (compressed) {
         decompressed_filesize = buffer.read_u32();
     }
+
+    INFO("File is valid XNB");
+    valid = true;
 }
 
 /*
@@ -135,23 +228,47 @@ void Xnb::read_header()
  * is then assumed to be 32 kb or 0x8000.
  *
  */
-Buffer Xnb::decompress_lzx()
+bool Xnb::decompress_lzx()
 {
+    if (filesize < XNB_COMPRESSED_HEADER_SIZE ||
+        filesize > buffer.data.size()) {
+        return false;
+    }
+
     size_t compressed_todo = filesize - XNB_COMPRESSED_HEADER_SIZE;
 
     DEBUG("File size: ", filesize,
           ", Decompresed size: ", decompressed_filesize);
 
-    auto compressed_data = buffer.peek(compressed_todo);
+    // NOTE: The size comes from the file and is allocated up front, so
+    // one the data can't decompress to is turned down first.
+    if (decompressed_filesize >
+        compressed_todo / LZX_MIN_FRAME_INPUT * LZX_MAX_FRAME_SIZE) {
+        return false;
+    }
 
-    buffer.cursor = XNB_COMPRESSED_HEADER_SIZE;
+    auto compressed_data = buffer.peek(compressed_todo);
 
     std::vector<uint8_t> decompressed_data(decompressed_filesize, 0);
 
-    auto lzx = LZXinit(16);
+    // A state handed in only needs resetting, which is a lot cheaper than
+    // allocating a new one and its window.
+    auto state = lzx;
+    if (state) {
+        LZXreset(state);
+    } else {
+        state = LZXinit(16);
+    }
+
+    LZXcounters counters = {};
+    if (stats) {
+        LZXsetcounters(state, &counters);
+        stats->detailed = LZXsetdetail(state, &stats->lzx);
+    }
 
     size_t out_pos = 0;
     size_t pos = 0;
+    bool ok = true;
 
     uint8_t hi;
     uint8_t lo;
@@ -159,7 +276,7 @@ Buffer Xnb::decompress_lzx()
     int block_size;
     int frame_size;
 
-    while (pos < compressed_todo) {
+    while (pos + 2 <= compressed_todo) {
 
         hi = compressed_data[pos++];
         lo = compressed_data[pos++];
@@ -168,6 +285,10 @@ Buffer Xnb::decompress_lzx()
         frame_size = 0x8000;
 
         if (hi == 0xFF) {
+            if (pos + 3 > compressed_todo) {
+                ok = false;
+                break;
+            }
             hi = lo;
             lo = compressed_data[pos++];
             frame_size = (hi << 8) | lo;
@@ -182,14 +303,40 @@ Buffer Xnb::decompress_lzx()
 
         DEBUG("Block Size: ", block_size, ", Frame Size: ", frame_size);
 
-        LZXdecompress(lzx, compressed_data.data() + pos,
-                      decompressed_data.data() + out_pos, block_size,
-                      frame_size);
+        if (pos + block_size > compressed_todo ||
+            out_pos + frame_size > decompressed_data.size() ||
+            LZXdecompress(state, compressed_data.data() + pos,
+                          decompressed_data.data() + out_pos, block_size,
+                          frame_size) != DECR_OK) {
+            ok = false;
+            break;
+        }
 
         out_pos += frame_size;
         pos += block_size;
+
+        if (stats) {
+            ++stats->counts[stats::Frames];
+        }
+    }
+
+    if (stats) {
+        stats->counts[stats::VerbatimBlocks] += counters.blocks[1];
+        stats->counts[stats::AlignedBlocks] += counters.blocks[2];
+        stats->counts[stats::UncompressedBlocks] += counters.blocks[3];
+        stats->counts[stats::Literals] += counters.literals;
+        stats->counts[stats::Matches] += counters.matches;
     }
 
-    LZXteardown(lzx);
-    return Buffer(decompressed_data);
+    if (state == lzx) {
+        LZXsetcounters(state, nullptr);
+        LZXsetdetail(state, nullptr);
+    } else {
+        LZXteardown(state);
+    }
+
+    if (ok) {
+        buffer = Buffer(std::move(decompressed_data));
+    }
+    return ok;
 }
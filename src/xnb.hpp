@@ -1,8 +1,14 @@
 #pragma once
 
 #include "buffer.hpp"
+#include "lzx.h"
+#include "readers/reader.hpp"
+#include "stats.hpp"
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 struct Xnb
 {
@@ -30,8 +36,33 @@ struct Xnb
     int reader_count = 0;
     int shared_resource_count = 0;
 
-    Xnb(std::string path);
+    readers::Manifest manifest;
+
+    // The reader of each type index as named in the file, viewing buffer.
+    std::vector<std::string_view> reader_names;
+    readers::ReaderPtr asset;
+
+    // Where the time goes and what was decoded are added up here, if set.
+    stats::Record *stats = nullptr;
+
+    // Decompresses with this state, reset first, rather than a new one, if
+    // set. It must have a 64K window.
+    LZXstate *lzx = nullptr;
+
+    // Reads the file at path and everything in it. asset is left empty if
+    // any of that fails.
+    Xnb(std::string path, stats::Record *stats = nullptr);
+    Xnb() = default;
+
+    // The steps of the above, for callers that want to time or skip them:
+    // open takes the bytes of the file and checks the header, decompress
+    // replaces buffer with the decompressed contents if they were
+    // compressed, and read_content reads the objects from it. Each returns
+    // false if its step fails.
+    bool open(std::vector<uint8_t> bytes);
+    bool decompress();
+    bool read_content();
 
     void read_header();
-    Buffer decompress_lzx();
+    bool decompress_lzx();
 };
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// XXH3, 64 bit, with the default secret and seed. Matches xxh3_64 of the
+// reference implementation, so hashes can be checked with other tools.
+uint64_t xxh3_64(std::span<const uint8_t> bytes);
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Regression check of the decoder against a corpus generated by xnbgen.
+# Each spec is written uncompressed and with every LZX block type, from
+# the same seeds, and all of them have to extract to the same outputs.
+#
+#   make check
+#   tools/check.sh [<xnb> <xnbgen> <work dir>]
+
+xnb=${1:-bin/xnb}
+xnbgen=${2:-bin/xnbgen}
+work=${3:-bin/check}
+
+# Small and large enough to span several 32 KiB frames, at the lowest
+# and highest entropy.
+SPECS="texture:color:64x64
+texture:color:300x200
+texture:dxt1:128x128:4
+texture:dxt5:256x256:3
+texture:bgr565:100x60
+texture:alpha8:512x512
+dictionary:3000
+strings:500:40
+strings:2000:100"
+
+BLOCKS="verbatim aligned uncompressed mixed"
+
+rm -rf "$work"
+failed=0
+
+for spec in $SPECS; do
+    for entropy in 0 4 8; do
+        name=$(echo "$spec" | tr ':' '_')_$entropy
+
+        for blocks in none $BLOCKS; do
+            in="$work/in/$name/$blocks"
+            out="$work/out/$name/$blocks"
+            if ! "$xnbgen" -n 3 --entropy $entropy --blocks $blocks \
+                "$spec" "$in" ||
+                ! "$xnb" -o "$out" "$in" >"$work/$name.$blocks.log" 2>&1; then
+                echo "FAIL $name $blocks: see $work/$name.$blocks.log"
+                failed=1
+            fi
+        done
+
+        for blocks in $BLOCKS; do
+            if ! diff -r "$work/out/$name/none" "$work/out/$name/$blocks" \
+                >/dev/null 2>&1; then
+                echo "FAIL $name: $blocks blocks differ from no LZX"
+                failed=1
+            fi
+        done
+    done
+done
+
+if [ $failed -ne 0 ]; then
+    exit 1
+fi
+echo "All generated files extract the same with every block type"
@@ -0,0 +1,540 @@
+#include "lzx_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace lzx
+{
+namespace
+{
+const size_t FRAME_SIZE = 0x8000;
+const size_t WINDOW_SIZE = 0x10000;
+const size_t MAX_OFFSET = WINDOW_SIZE - 3;
+
+// LZX allows matches of 2, which rarely pay for themselves.
+const size_t MIN_MATCH = 3;
+const size_t MAX_MATCH = 257;
+
+const int NUM_CHARS = 256;
+const int NUM_PRIMARY_LENGTHS = 7;
+const int POSITION_SLOTS = 32;
+const int MAIN_ELEMENTS = NUM_CHARS + POSITION_SLOTS * 8;
+const int SECONDARY_LENGTHS = 249;
+const int PRETREE_ELEMENTS = 20;
+const int ALIGNED_ELEMENTS = 8;
+
+const int HASH_BITS = 16;
+const int CHAIN_DEPTH = 32;
+const size_t NONE = SIZE_MAX;
+
+// As in src/lzx.cpp, for the slots a 64 KiB window uses.
+const uint8_t EXTRA_BITS[POSITION_SLOTS] = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,  6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14};
+
+const uint32_t POSITION_BASE[POSITION_SLOTS] = {
+    0,    1,    2,    3,    4,     6,     8,     12,    16,   24,   32,
+    48,   64,   96,   128,  192,   256,   384,   512,   768,  1024, 1536,
+    2048, 3072, 4096, 6144, 8192,  12288, 16384, 24576, 32768, 49152};
+
+// Bits go in most significant first, packed into 16 bit little endian
+// words.
+struct BitWriter
+{
+    std::vector<uint8_t> &out;
+    uint32_t bits = 0;
+    int count = 0;
+
+    void write(uint32_t value, int n)
+    {
+        if (n > 16) {
+            write(value >> 16, n - 16);
+            value &= 0xFFFF;
+            n = 16;
+        }
+
+        bits = (bits << n) | value;
+        count += n;
+
+        if (count >= 16) {
+            count -= 16;
+            uint16_t word = bits >> count;
+            out.push_back(word & 0xFF);
+            out.push_back(word >> 8);
+            bits &= (1u << count) - 1;
+        }
+    }
+
+    void flush()
+    {
+        if (count > 0) {
+            write(0, 16 - count);
+        }
+    }
+};
+
+// A canonical Huffman code, in the order make_decode_table expects:
+// shorter codes first, then by symbol.
+struct Tree
+{
+    std::vector<uint8_t> lengths;
+    std::vector<uint16_t> codes;
+
+    Tree(const std::vector<uint32_t> &freqs, int limit)
+        : lengths(freqs.size(), 0), codes(freqs.size(), 0)
+    {
+        build_lengths(freqs, limit);
+
+        uint16_t count[17] = {};
+        for (auto length : lengths) {
+            ++count[length];
+        }
+        count[0] = 0;
+
+        uint16_t next[17] = {};
+        uint16_t code = 0;
+        for (int bits = 1; bits <= 16; ++bits) {
+            code = (code + count[bits - 1]) << 1;
+            next[bits] = code;
+        }
+
+        for (size_t i = 0; i < lengths.size(); ++i) {
+            if (lengths[i]) {
+                codes[i] = next[lengths[i]]++;
+            }
+        }
+    }
+
+    void write(BitWriter &out, int symbol) const
+    {
+        out.write(codes[symbol], lengths[symbol]);
+    }
+
+    // NOTE: The decoder rejects a tree with a single code, so a lone
+    // symbol gets a partner. A tree without any is fine.
+    void build_lengths(const std::vector<uint32_t> &freqs, int limit)
+    {
+        std::vector<size_t> used;
+        for (size_t i = 0; i < freqs.size(); ++i) {
+            if (freqs[i]) {
+                used.push_back(i);
+            }
+        }
+
+        if (used.size() < 2) {
+            if (used.size() == 1) {
+                lengths[used[0]] = 1;
+                lengths[used[0] == 0 ? 1 : 0] = 1;
+            }
+            return;
+        }
+
+        std::vector<uint64_t> weights;
+        for (auto symbol : used) {
+            weights.push_back(freqs[symbol]);
+        }
+
+        // Frequencies are flattened until the deepest code fits.
+        for (;;) {
+            size_t leaves = used.size();
+            std::vector<size_t> parent(2 * leaves - 1);
+            std::priority_queue<std::pair<uint64_t, size_t>,
+                                std::vector<std::pair<uint64_t, size_t>>,
+                                std::greater<>>
+                queue;
+
+            for (size_t i = 0; i < leaves; ++i) {
+                queue.push({weights[i], i});
+            }
+
+            size_t next = leaves;
+            while (queue.size() > 1) {
+                auto a = queue.top();
+                queue.pop();
+                auto b = queue.top();
+                queue.pop();
+                parent[a.second] = parent[b.second] = next;
+                queue.push({a.first + b.first, next++});
+            }
+
+            // Parents always come after their children.
+            std::vector<int> depth(2 * leaves - 1, 0);
+            for (size_t i = 2 * leaves - 2; i-- > 0;) {
+                depth[i] = depth[parent[i]] + 1;
+            }
+
+            int deepest = *std::max_element(depth.begin(),
+                                            depth.begin() + leaves);
+            if (deepest <= limit) {
+                for (size_t i = 0; i < leaves; ++i) {
+                    lengths[used[i]] = depth[i];
+                }
+                return;
+            }
+
+            for (auto &weight : weights) {
+                weight = (weight >> 1) | 1;
+            }
+        }
+    }
+};
+
+struct Token
+{
+    uint16_t length; // 0 for a literal
+    uint16_t value;  // the literal, or the position slot of a match
+    uint32_t footer; // the offset past the slot's base
+};
+
+struct Encoder
+{
+    std::span<const uint8_t> data;
+
+    std::vector<size_t> head = std::vector<size_t>(1 << HASH_BITS, NONE);
+    std::vector<size_t> chain = std::vector<size_t>(WINDOW_SIZE, NONE);
+
+    // The decoder's repeated offsets and tree lengths, mirrored, since
+    // both carry over from block to block.
+    uint32_t recent[3] = {1, 1, 1};
+    std::vector<uint8_t> main_lengths = std::vector<uint8_t>(MAIN_ELEMENTS);
+    std::vector<uint8_t> length_lengths =
+        std::vector<uint8_t>(SECONDARY_LENGTHS);
+
+    bool header_written = false;
+    bool odd_uncompressed = false;
+
+    void insert(size_t pos)
+    {
+        if (pos + 3 > data.size()) {
+            return;
+        }
+        uint32_t hash = (data[pos] << 16) | (data[pos + 1] << 8) |
+                        data[pos + 2];
+        hash = (hash * 2654435761u) >> (32 - HASH_BITS);
+
+        chain[pos & (WINDOW_SIZE - 1)] = head[hash];
+        head[hash] = pos;
+    }
+
+    size_t candidates(size_t pos)
+    {
+        if (pos + 3 > data.size()) {
+            return NONE;
+        }
+        uint32_t hash = (data[pos] << 16) | (data[pos + 1] << 8) |
+                        data[pos + 2];
+        return head[(hash * 2654435761u) >> (32 - HASH_BITS)];
+    }
+
+    size_t match_length(size_t from, size_t pos, size_t limit)
+    {
+        size_t length = 0;
+        while (length < limit && data[from + length] == data[pos + length]) {
+            ++length;
+        }
+        return length;
+    }
+
+    // Turns the match into a slot and footer, updating the repeated
+    // offsets the same way the decoder will.
+    Token match(size_t length, uint32_t offset)
+    {
+        uint32_t *r = recent;
+
+        if (offset == r[0]) {
+            return {uint16_t(length), 0, 0};
+        } else if (offset == r[1]) {
+            std::swap(r[0], r[1]);
+            return {uint16_t(length), 1, 0};
+        } else if (offset == r[2]) {
+            std::swap(r[0], r[2]);
+            return {uint16_t(length), 2, 0};
+        }
+
+        r[2] = r[1];
+        r[1] = r[0];
+        r[0] = offset;
+
+        uint32_t formatted = offset + 2;
+        int slot = std::upper_bound(POSITION_BASE,
+                                    POSITION_BASE + POSITION_SLOTS,
+                                    formatted) -
+                   POSITION_BASE - 1;
+        return {uint16_t(length), uint16_t(slot),
+                formatted - POSITION_BASE[slot]};
+    }
+
+    // NOTE: Matches can't run past the end of a frame, the decoder would
+    // write them into the next one.
+    std::vector<Token> tokenize(size_t start, size_t end)
+    {
+        std::vector<Token> tokens;
+        size_t pos = start;
+
+        while (pos < end) {
+            size_t limit = std::min(MAX_MATCH, end - pos);
+            size_t best = 0;
+            uint32_t offset = 0;
+
+            // Repeated offsets are the cheapest to encode, so they win
+            // ties.
+            for (uint32_t candidate : recent) {
+                if (candidate > pos || candidate > MAX_OFFSET) {
+                    continue;
+                }
+                size_t length = match_length(pos - candidate, pos, limit);
+                if (length > best) {
+                    best = length;
+                    offset = candidate;
+                }
+            }
+
+            size_t from = candidates(pos);
+            for (int depth = 0; from != NONE && depth < CHAIN_DEPTH;
+                 ++depth) {
+                if (pos - from > MAX_OFFSET || best == limit) {
+                    break;
+                }
+                size_t length = match_length(from, pos, limit);
+                if (length > best) {
+                    best = length;
+                    offset = pos - from;
+                }
+                from = chain[from & (WINDOW_SIZE - 1)];
+            }
+
+            if (best >= MIN_MATCH) {
+                tokens.push_back(match(best, offset));
+                for (size_t i = 0; i < best; ++i) {
+                    insert(pos + i);
+                }
+                pos += best;
+            } else {
+                tokens.push_back({0, data[pos], 0});
+                insert(pos++);
+            }
+        }
+
+        return tokens;
+    }
+
+    // Tree lengths are sent as differences from the previous block's,
+    // coded with a pretree of their own. Symbols 17 and 18 are runs of
+    // zeros.
+    void write_lengths(BitWriter &out, std::vector<uint8_t> &previous,
+                       const std::vector<uint8_t> &lengths, size_t first,
+                       size_t last)
+    {
+        std::vector<std::pair<int, uint32_t>> symbols;
+
+        for (size_t x = first; x < last;) {
+            size_t run = 0;
+            while (x + run < last && lengths[x + run] == 0) {
+                ++run;
+            }
+
+            if (run >= 20) {
+                run = std::min<size_t>(run, 51);
+                symbols.push_back({18, uint32_t(run - 20)});
+                x += run;
+            } else if (run >= 4) {
+                symbols.push_back({17, uint32_t(run - 4)});
+                x += run;
+            } else {
+                symbols.push_back({(previous[x] - lengths[x] + 17) % 17, 0});
+                ++x;
+            }
+        }
+
+        std::vector<uint32_t> freqs(PRETREE_ELEMENTS);
+        for (auto &symbol : symbols) {
+            ++freqs[symbol.first];
+        }
+
+        Tree pretree(freqs, 15);
+        for (auto length : pretree.lengths) {
+            out.write(length, 4);
+        }
+
+        for (auto [symbol, extra] : symbols) {
+            pretree.write(out, symbol);
+            if (symbol == 17) {
+                out.write(extra, 4);
+            } else if (symbol == 18) {
+                out.write(extra, 5);
+            }
+        }
+
+        std::copy(lengths.begin() + first, lengths.begin() + last,
+                  previous.begin() + first);
+    }
+
+    // The frame's output split evenly into a block of each type in turn.
+    // Blocks follow each other in one bit stream, apart from uncompressed
+    // ones, which are realigned to 16 bits.
+    std::vector<uint8_t> frame(size_t start, size_t end,
+                               std::span<const BlockType> types)
+    {
+        std::vector<uint8_t> chunk;
+        BitWriter out{chunk};
+
+        for (size_t i = 0; i < types.size(); ++i) {
+            size_t from = start + (end - start) * i / types.size();
+            size_t to = start + (end - start) * (i + 1) / types.size();
+            if (from < to) {
+                block(out, from, to, types[i]);
+            }
+        }
+
+        out.flush();
+        return chunk;
+    }
+
+    void block(BitWriter &out, size_t start, size_t end, BlockType type)
+    {
+        auto &chunk = out.out;
+
+        // The decoder skips a byte after an uncompressed block of odd
+        // length, before the next block's header, which may be at the
+        // start of the next frame.
+        if (odd_uncompressed) {
+            chunk.push_back(0);
+            odd_uncompressed = false;
+        }
+
+        // No E8 call translation.
+        if (!header_written) {
+            out.write(0, 1);
+            header_written = true;
+        }
+
+        size_t length = end - start;
+        out.write(type, 3);
+        out.write(length >> 8, 16);
+        out.write(length & 0xFF, 8);
+
+        if (type == Uncompressed) {
+            for (size_t pos = start; pos < end; ++pos) {
+                insert(pos);
+            }
+
+            // 1 to 16 bits of padding, then the repeated offsets.
+            if (out.count == 0) {
+                out.write(0, 16);
+            }
+            out.flush();
+
+            for (uint32_t offset : recent) {
+                for (int i = 0; i < 4; ++i) {
+                    chunk.push_back(uint8_t(offset >> (8 * i)));
+                }
+            }
+
+            chunk.insert(chunk.end(), data.begin() + start,
+                         data.begin() + end);
+            odd_uncompressed = length & 1;
+            return;
+        }
+
+        auto tokens = tokenize(start, end);
+
+        std::vector<uint32_t> main_freqs(MAIN_ELEMENTS);
+        std::vector<uint32_t> length_freqs(SECONDARY_LENGTHS);
+        std::vector<uint32_t> aligned_freqs(ALIGNED_ELEMENTS);
+
+        for (auto &token : tokens) {
+            if (token.length == 0) {
+                ++main_freqs[token.value];
+                continue;
+            }
+
+            int header = std::min(token.length - 2, NUM_PRIMARY_LENGTHS);
+            ++main_freqs[NUM_CHARS + (token.value << 3 | header)];
+            if (header == NUM_PRIMARY_LENGTHS) {
+                ++length_freqs[token.length - 2 - NUM_PRIMARY_LENGTHS];
+            }
+            if (type == Aligned && EXTRA_BITS[token.value] >= 3) {
+                ++aligned_freqs[token.footer & 7];
+            }
+        }
+
+        Tree main_tree(main_freqs, 16);
+        Tree length_tree(length_freqs, 16);
+        Tree aligned_tree(aligned_freqs, 7);
+
+        if (type == Aligned) {
+            for (auto length : aligned_tree.lengths) {
+                out.write(length, 3);
+            }
+        }
+
+        write_lengths(out, main_lengths, main_tree.lengths, 0, NUM_CHARS);
+        write_lengths(out, main_lengths, main_tree.lengths, NUM_CHARS,
+                      MAIN_ELEMENTS);
+        write_lengths(out, length_lengths, length_tree.lengths, 0,
+                      SECONDARY_LENGTHS);
+
+        for (auto &token : tokens) {
+            if (token.length == 0) {
+                main_tree.write(out, token.value);
+                continue;
+            }
+
+            int header = std::min(token.length - 2, NUM_PRIMARY_LENGTHS);
+            main_tree.write(out, NUM_CHARS + (token.value << 3 | header));
+            if (header == NUM_PRIMARY_LENGTHS) {
+                length_tree.write(out,
+                                  token.length - 2 - NUM_PRIMARY_LENGTHS);
+            }
+
+            // Repeated offsets and slot 3 have no footer.
+            int extra = EXTRA_BITS[token.value];
+            if (extra == 0) {
+                continue;
+            }
+
+            if (type == Aligned && extra >= 3) {
+                if (extra > 3) {
+                    out.write(token.footer >> 3, extra - 3);
+                }
+                aligned_tree.write(out, token.footer & 7);
+            } else {
+                out.write(token.footer, extra);
+            }
+        }
+    }
+};
+} // namespace
+
+std::vector<uint8_t> compress(std::span<const uint8_t> data,
+                              std::span<const BlockType> types)
+{
+    Encoder encoder{data};
+    std::vector<uint8_t> out;
+
+    for (size_t start = 0; start < data.size(); start += FRAME_SIZE) {
+        size_t end = std::min(start + FRAME_SIZE, data.size());
+        auto chunk = encoder.frame(start, end, types);
+
+        // Frames of the default size only carry the size of their block.
+        size_t size = end - start;
+        if (size != FRAME_SIZE) {
+            out.push_back(0xFF);
+            out.push_back(uint8_t(size >> 8));
+            out.push_back(uint8_t(size));
+        }
+        out.push_back(uint8_t(chunk.size() >> 8));
+        out.push_back(uint8_t(chunk.size()));
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+
+    return out;
+}
+} // namespace lzx
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lzx
+{
+enum BlockType
+{
+    Verbatim = 1,
+    Aligned = 2,
+    Uncompressed = 3
+};
+
+/*
+ * Compresses data the way XNB files store it for src/lzx.cpp: a 64 KiB
+ * window, split into frames of 32 KiB of output, each flushed to a 16 bit
+ * boundary and prefixed with its sizes. Every frame is split evenly into
+ * a block of each of the types in turn, so even a file of one frame has
+ * every type in it.
+ *
+ * Matches are found greedily through hash chains. The point is valid
+ * input for the decoder with each block type, not the best ratio.
+ */
+std::vector<uint8_t> compress(std::span<const uint8_t> data,
+                              std::span<const BlockType> types);
+} // namespace lzx
@@ -0,0 +1,373 @@
+// Writes synthetic XNB files, for benchmarking and stress testing without
+// game assets. The same seed always gives the same files.
+//
+//   make bin/xnbgen && bin/xnbgen [options] <spec> <output>
+
+#include "lzx_encoder.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+const std::string CONTENT = "Microsoft.Xna.Framework.Content.";
+const std::string MSCORLIB = ", mscorlib, Version=4.0.0.0, Culture=neutral, "
+                             "PublicKeyToken=b77a5c561934e089";
+
+// SplitMix64, so the output doesn't depend on the standard library.
+struct Random
+{
+    uint64_t state;
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        return z ^ (z >> 31);
+    }
+};
+
+struct Options
+{
+    uint64_t seed = 1;
+
+    // Random bits in each byte of generated data, from 0 (a repeating
+    // pattern) to 8 (noise).
+    int entropy = 4;
+
+    // Block types each frame is split between. Empty writes the file
+    // uncompressed.
+    std::vector<lzx::BlockType> blocks = {lzx::Verbatim};
+};
+
+struct Writer
+{
+    std::vector<uint8_t> bytes;
+
+    void u8(uint8_t value) { bytes.push_back(value); }
+
+    void u32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) {
+            bytes.push_back(uint8_t(value >> (8 * i)));
+        }
+    }
+
+    void varint(uint32_t value)
+    {
+        while (value >= 0x80) {
+            bytes.push_back(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        bytes.push_back(uint8_t(value));
+    }
+
+    void string(std::string_view value)
+    {
+        varint(value.size());
+        bytes.insert(bytes.end(), value.begin(), value.end());
+    }
+};
+
+// The readers, no shared resources, and the primary asset's type index.
+// Readers are numbered from 1 in the file.
+Writer content(const std::vector<std::string> &readers)
+{
+    Writer out;
+    out.varint(readers.size());
+    for (auto &reader : readers) {
+        out.string(reader);
+        out.u32(0);
+    }
+    out.varint(0);
+    out.varint(1);
+    return out;
+}
+
+uint8_t noisy(Random &random, uint8_t pattern, int entropy)
+{
+    return pattern ^ uint8_t(random.next() & ((1u << entropy) - 1));
+}
+
+std::string text(Random &random, size_t length, int entropy)
+{
+    static const char ALPHABET[] = "etaoinshrdlucmfwypvbgkqjxzETAOINSH"
+                                   "RDLUCMFWYPVBGKQJXZ0123456789_-";
+
+    // Strings are drawn from up to 64 letters, so 6 bits at most.
+    size_t letters = size_t(1) << std::min(entropy, 6);
+
+    std::string out;
+    for (size_t i = 0; i < length; ++i) {
+        out += ALPHABET[(i + random.next() % letters) % 64];
+    }
+    return out;
+}
+
+void texture(Writer &out, Random &random, const Options &options,
+             int format, int width, int height, int mips)
+{
+    out.u32(format);
+    out.u32(width);
+    out.u32(height);
+    out.u32(mips);
+
+    for (int level = 0; level < mips; ++level) {
+        int w = std::max(width >> level, 1);
+        int h = std::max(height >> level, 1);
+        size_t size = texture::image_size(format, w, h);
+
+        // Rows of pixels, or of 4x4 blocks.
+        size_t units = texture::compressed(format) ? (w + 3) / 4 : w;
+        size_t row = units * texture::unit_size(format);
+
+        out.u32(size);
+        for (size_t i = 0; i < size; ++i) {
+            size_t x = i % row;
+            size_t y = i / row;
+            out.u8(noisy(random, uint8_t(x ^ y), options.entropy));
+        }
+    }
+}
+
+bool parse_format(std::string_view name, int &format)
+{
+    static const std::pair<std::string_view, int> FORMATS[] = {
+        {"color", texture::Color},       {"bgr565", texture::Bgr565},
+        {"bgra5551", texture::Bgra5551}, {"bgra4444", texture::Bgra4444},
+        {"dxt1", texture::Dxt1},         {"dxt3", texture::Dxt3},
+        {"dxt5", texture::Dxt5},         {"alpha8", texture::Alpha8},
+    };
+
+    for (auto &[key, value] : FORMATS) {
+        if (key == name) {
+            format = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> split(std::string_view spec)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (size_t colon; (colon = spec.find(':', start)) != spec.npos;
+         start = colon + 1) {
+        parts.emplace_back(spec.substr(start, colon - start));
+    }
+    parts.emplace_back(spec.substr(start));
+    return parts;
+}
+
+/*
+ * The contents of one file, following spec:
+ *
+ *   texture:<format>:<width>x<height>[:<mips>]
+ *   dictionary:<entries>     Dictionary<string, int>
+ *   strings:<count>:<length> List<string>
+ */
+bool generate(std::string_view spec, Random &random, const Options &options,
+              Writer &out)
+{
+    auto parts = split(spec);
+    auto number = [&](size_t i) { return std::stoul(parts.at(i)); };
+
+    try {
+        if (parts[0] == "texture" && parts.size() >= 3) {
+            int format;
+            auto x = parts[2].find('x');
+            if (!parse_format(parts[1], format) || x == std::string::npos) {
+                return false;
+            }
+
+            int width = std::stoi(parts[2].substr(0, x));
+            int height = std::stoi(parts[2].substr(x + 1));
+            int mips = parts.size() > 3 ? number(3) : 1;
+            if (width < 1 || height < 1 || mips < 1) {
+                return false;
+            }
+
+            out = content({CONTENT + "Texture2DReader, Microsoft.Xna."
+                                     "Framework.Graphics"});
+            texture(out, random, options, format, width, height, mips);
+            return true;
+        } else if (parts[0] == "dictionary" && parts.size() == 2) {
+            size_t entries = number(1);
+
+            out = content({CONTENT + "DictionaryReader`2[[System.String" +
+                               MSCORLIB + "],[System.Int32" + MSCORLIB +
+                               "]]",
+                           CONTENT + "StringReader", CONTENT + "Int32Reader"});
+            out.u32(entries);
+
+            // Keys are kept unique by their index.
+            for (size_t i = 0; i < entries; ++i) {
+                out.varint(2);
+                out.string(std::to_string(i) + "_" +
+                           text(random, 8, options.entropy));
+                out.u32(random.next() & ((1ull << (4 * options.entropy)) - 1));
+            }
+            return true;
+        } else if (parts[0] == "strings" && parts.size() == 3) {
+            size_t count = number(1);
+            size_t length = number(2);
+
+            out = content({CONTENT + "ListReader`1[[System.String" +
+                               MSCORLIB + "]]",
+                           CONTENT + "StringReader"});
+            out.u32(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                out.varint(2);
+                out.string(text(random, length, options.entropy));
+            }
+            return true;
+        }
+    } catch (const std::exception &) {
+    }
+
+    return false;
+}
+
+// Wraps the contents in the XNB header, compressing them if asked to.
+bool write(const fs::path &path, const Writer &body, const Options &options)
+{
+    Writer out;
+    out.bytes = {'X', 'N', 'B', 'w', 5};
+
+    if (options.blocks.empty()) {
+        out.u8(0);
+        out.u32(10 + body.bytes.size());
+        out.bytes.insert(out.bytes.end(), body.bytes.begin(),
+                         body.bytes.end());
+    } else {
+        auto packed = lzx::compress(body.bytes, options.blocks);
+        out.u8(0x80);
+        out.u32(14 + packed.size());
+        out.u32(body.bytes.size());
+        out.bytes.insert(out.bytes.end(), packed.begin(), packed.end());
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.bytes.data()),
+               out.bytes.size());
+    return bool(file);
+}
+
+bool parse_blocks(std::string_view name, std::vector<lzx::BlockType> &blocks)
+{
+    if (name == "none") {
+        blocks = {};
+    } else if (name == "verbatim") {
+        blocks = {lzx::Verbatim};
+    } else if (name == "aligned") {
+        blocks = {lzx::Aligned};
+    } else if (name == "uncompressed") {
+        blocks = {lzx::Uncompressed};
+    } else if (name == "mixed") {
+        blocks = {lzx::Verbatim, lzx::Aligned, lzx::Uncompressed};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void usage(const char *name)
+{
+    std::cerr
+        << "usage: " << name
+        << " [-n <count>] [--seed <n>] [--entropy <bits>]"
+        << " [--blocks <type>] <spec> <output>\n"
+        << "  <spec>  texture:<format>:<width>x<height>[:<mips>]\n"
+        << "          with format color, bgr565, bgra5551, bgra4444,"
+        << " dxt1, dxt3,\n"
+        << "          dxt5 or alpha8\n"
+        << "          dictionary:<entries>\n"
+        << "          strings:<count>:<length>\n"
+        << "  -n <count>        write count files into the output"
+        << " directory\n"
+        << "  --seed <n>        seed for the contents (default: 1)\n"
+        << "  --entropy <bits>  random bits per byte, 0 to 8 (default: 4)\n"
+        << "  --blocks <none | verbatim | aligned | uncompressed | mixed>\n"
+        << "                    LZX block types, or none to leave the file\n"
+        << "                    uncompressed (default: verbatim). mixed\n"
+        << "                    splits every frame into one block of each\n";
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    size_t count = 0;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+
+        if (arg == "-n" && i + 1 < argc) {
+            count = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--entropy" && i + 1 < argc) {
+            options.entropy = std::clamp(std::stoi(argv[++i]), 0, 8);
+        } else if (arg == "--blocks" && i + 1 < argc) {
+            if (!parse_blocks(argv[++i], options.blocks)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg.starts_with("-")) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    auto &spec = positional[0];
+    fs::path output = positional[1];
+    if (count > 0) {
+        fs::create_directories(output);
+    }
+
+    // Each file gets a seed of its own, so any one of them can be
+    // regenerated alone.
+    for (size_t i = 0; i < std::max<size_t>(count, 1); ++i) {
+        Random random{options.seed + i * 0x9E3779B97F4A7C15};
+        Writer body;
+
+        if (!generate(spec, random, options, body)) {
+            std::cerr << "Bad spec: " << spec << "\n";
+            usage(argv[0]);
+            return 1;
+        }
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%06zu.xnb", i);
+        auto path = count > 0 ? output / name : output;
+
+        if (!write(path, body, options)) {
+            std::cerr << "Could not write " << path << "\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}